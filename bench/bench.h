@@ -0,0 +1,15 @@
+// Helpers shared by the benchmarks.
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <time.h>
+
+// benchNow returns monotonic time in seconds.
+static double benchNow(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+#endif // BENCH_H
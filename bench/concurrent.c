@@ -0,0 +1,53 @@
+// Parses per second when threads share one FlagSet through their own
+// FlagContext.
+
+#define FLAGS_IMPLEMENTATION
+#include "flag.h"
+#include "bench/bench.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#define ITERATIONS 200000
+
+static FlagSet* fs;
+
+static void* worker(void* arg) {
+  (void)arg;
+  FlagContext* ctx    = flagContextNew(fs);
+  char*        argv[] = { "bench", "--port", "8080", "-v", "--name", "x", "--ratio", "0.5" };
+  for (long i = 0; i < ITERATIONS; i++) {
+    flagContextReset(ctx);
+    if (!flagContextParse(ctx, 8, argv)) {
+      flagContextPrintError(ctx, stderr);
+      exit(1);
+    }
+  }
+  flagContextFree(ctx);
+  return NULL;
+}
+
+int main(void) {
+  fs = flagSetNew();
+  flagSetIntVar(fs, NULL, "port", 'p', 80, "port");
+  flagSetBoolVar(fs, NULL, "verbose", 'v', "verbose");
+  flagSetStringVar(fs, NULL, "name", 'n', "", "name");
+  flagSetDoubleVar(fs, NULL, "ratio", 'r', 1.0, "ratio");
+
+  static const int counts[] = { 1, 2, 4, 8 };
+  for (int k = 0; k < CAST(int, sizeof(counts) / sizeof(counts[0])); k++) {
+    pthread_t threads[8];
+    double    start = benchNow();
+    for (int i = 0; i < counts[k]; i++) {
+      pthread_create(&threads[i], NULL, worker, NULL);
+    }
+    for (int i = 0; i < counts[k]; i++) {
+      pthread_join(threads[i], NULL);
+    }
+    double elapsed = benchNow() - start;
+    printf("threads=%d %6.2fM parses/s\n", counts[k], counts[k] * ITERATIONS / elapsed / 1e6);
+  }
+
+  flagSetFree(fs);
+  return 0;
+}
@@ -0,0 +1,52 @@
+// Parse time per argument as the number of registered flags grows. Long names
+// are resolved through the hash index, so time per argument should stay flat.
+
+#define FLAGS_IMPLEMENTATION
+#include "flag.h"
+#include "bench/bench.h"
+
+#include <stdlib.h>
+
+#define MAX_FLAGS 2048
+#define ARGS      100
+#define ROUNDS    20000
+
+static char names[MAX_FLAGS][32];
+static int  values[MAX_FLAGS];
+
+int main(void) {
+  static const int counts[] = { 8, 32, 128, 512, 2048 };
+
+  for (int k = 0; k < CAST(int, sizeof(counts) / sizeof(counts[0])); k++) {
+    int      n  = counts[k];
+    FlagSet* fs = flagSetNew();
+    for (int i = 0; i < n; i++) {
+      snprintf(names[i], sizeof(names[i]), "option-name-%d", i);
+      flagSetIntVar(fs, values + i, names[i], 0, 0, "");
+    }
+
+    // Arguments name flags spread over the whole set.
+    char  buf[ARGS][40];
+    char* argv[1 + ARGS * 2];
+    argv[0] = CAST(char*, "bench");
+    for (int i = 0; i < ARGS; i++) {
+      snprintf(buf[i], sizeof(buf[i]), "--%s", names[(i * 7919) % n]);
+      argv[1 + i * 2] = buf[i];
+      argv[2 + i * 2] = CAST(char*, "5");
+    }
+
+    // flagSetReset is O(flags), so it is left out of the measured loop.
+    double start = benchNow();
+    for (int r = 0; r < ROUNDS; r++) {
+      if (!flagSetParse(fs, 1 + ARGS * 2, argv)) {
+        flagSetPrintError(fs, stderr);
+      }
+    }
+    double elapsed = benchNow() - start;
+
+    printf("flags=%-5d %6.1f ns/arg\n", n, elapsed / ROUNDS / ARGS * 1e9);
+    flagSetFree(fs);
+  }
+
+  return 0;
+}
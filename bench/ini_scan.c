@@ -0,0 +1,99 @@
+// Throughput of the INI parser for stream, mapped and in-memory input on a
+// large generated file.
+
+#define INI_IMPLEMENTATION
+#include "ini.h"
+#include "bench/bench.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#define GROUPS 2000
+#define KEYS   50
+#define ROUNDS   5
+
+// writeInput writes the generated INI file and returns its size.
+static long writeInput(char* path) {
+  int fd = mkstemp(path);
+  if (fd < 0) return -1;
+  FILE* f = fdopen(fd, "w");
+  if (f == NULL) return -1;
+  for (int g = 0; g < GROUPS; g++) {
+    fprintf(f, "; group %d\n", g);
+    for (int k = 0; k < KEYS; k++) {
+      fprintf(f, "  group_%d_option_%d = value of the option number %d\n", g, k, k);
+    }
+    fprintf(f, "\n");
+  }
+  long size = ftell(f);
+  fclose(f);
+  return size;
+}
+
+// scanSlices walks all keys and values without copying them.
+static long scanSlices(IniParser* p) {
+  IniSlice key, value;
+  long     n = 0;
+  while (iniParseKeySlice(p, &key) > 0) {
+    iniParseValueSlice(p, &value);
+    n++;
+  }
+  return n;
+}
+
+// report prints throughput of ROUNDS passes over size bytes.
+static void report(const char* name, long size, double elapsed, long keys) {
+  printf("%-8s %8.0f MB/s (%ld keys)\n", name, CAST(double, size) * ROUNDS / elapsed / 1e6, keys / ROUNDS);
+}
+
+int main(void) {
+  char path[] = "/tmp/ini_scan_XXXXXX";
+  long size   = writeInput(path);
+  if (size < 0) {
+    perror("ini_scan");
+    return 1;
+  }
+
+  char* data = malloc(size);
+  FILE* f    = fopen(path, "r");
+  if (data == NULL || f == NULL || fread(data, 1, size, f) != CAST(size_t, size)) {
+    perror("ini_scan");
+    return 1;
+  }
+  fclose(f);
+
+  char   key[128], value[512];
+  long   keys  = 0;
+  double start = benchNow();
+  for (int r = 0; r < ROUNDS; r++) {
+    IniParser* p = iniParserOpen(path);
+    while (iniParseKey(p, key, sizeof(key)) > 0) {
+      iniParseValue(p, value, sizeof(value));
+      keys++;
+    }
+    iniParserFree(p);
+  }
+  report("FILE*", size, benchNow() - start, keys);
+
+  keys  = 0;
+  start = benchNow();
+  for (int r = 0; r < ROUNDS; r++) {
+    IniParser* p = iniParserMap(path);
+    keys += scanSlices(p);
+    iniParserFree(p);
+  }
+  report("mmap", size, benchNow() - start, keys);
+
+  keys  = 0;
+  start = benchNow();
+  for (int r = 0; r < ROUNDS; r++) {
+    IniParser* p = iniParserBuffer(data, size);
+    keys += scanSlices(p);
+    iniParserFree(p);
+  }
+  report("buffer", size, benchNow() - start, keys);
+
+  free(data);
+  unlink(path);
+  return 0;
+}
@@ -0,0 +1,41 @@
+// Cost of converting integer values with flagParseValue compared to strtol.
+
+#define FLAGS_IMPLEMENTATION
+#include "flag.h"
+#include "bench/bench.h"
+
+#include <stdlib.h>
+
+#define VALUES 1000
+#define ROUNDS 20000
+
+int main(void) {
+  static char values[VALUES][24];
+  for (int i = 0; i < VALUES; i++) {
+    snprintf(values[i], sizeof(values[i]), "%ld", (i * 7919L * 131) % 2000000000 - 1000000000);
+  }
+
+  volatile long sink  = 0;
+  double        start = benchNow();
+  for (int r = 0; r < ROUNDS; r++) {
+    for (int i = 0; i < VALUES; i++) {
+      char* end;
+      sink += strtol(values[i], &end, 10);
+    }
+  }
+  double strtol_time = benchNow() - start;
+
+  start = benchNow();
+  for (int r = 0; r < ROUNDS; r++) {
+    for (int i = 0; i < VALUES; i++) {
+      int v = 0;
+      flagParseValue(FLAG_TYPE_INT, &v, values[i]);
+      sink += v;
+    }
+  }
+  double flag_time = benchNow() - start;
+
+  printf("strtol         %5.1f ns/value\n", strtol_time / ROUNDS / VALUES * 1e9);
+  printf("flagParseValue %5.1f ns/value\n", flag_time / ROUNDS / VALUES * 1e9);
+  return 0;
+}
@@ -27,10 +27,18 @@
 #include <time.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 
-// Maximum number of flags that could be registered.
-#ifndef FLAGS_MAX
-#define FLAGS_MAX 256
+// Number of flags the flag set allocates room for on the first registration.
+// Storage doubles every time it runs out, so there is no upper limit.
+#ifndef FLAGS_MIN_CAPACITY
+#define FLAGS_MIN_CAPACITY 8
+#endif
+
+// Size of the blocks of the flag set arena that owns strings parsed from
+// configuration, larger strings get a block of their own.
+#ifndef FLAGS_ARENA_BLOCK_SIZE
+#define FLAGS_ARENA_BLOCK_SIZE 4096
 #endif
 
 // Maximum number of characters in the flag or env string.
@@ -38,12 +46,162 @@
 #define FLAGS_FLAG_MAX_LEN 64
 #endif
 
-// Library format for time
+// Suffix of the snapshot compiled from the configuration file, see
+// flagSetCompileConfig.
+#ifndef FLAGS_SNAPSHOT_SUFFIX
+#define FLAGS_SNAPSHOT_SUFFIX ".snap"
+#endif
+
+// Library format for time. The default layout is parsed without strptime and
+// mktime and may be followed by "Z" or by the offset "+HH:MM" / "-HH:MM",
+// values without suffix are in the local standard time.
 #ifndef FLAGS_TIME_FMT
 #define FLAGS_TIME_FMT "%Y-%m-%dT%H:%M:%S"
 #endif
 
 typedef struct FlagSet FlagSet;
+typedef struct FlagContext FlagContext;
+typedef struct FlagView FlagView;
+
+// Atomic flags, views and watches need C++11 or C11 atomics. FLAGS_NO_ATOMICS
+// leaves them out, it is defined for C compilers without <stdatomic.h>.
+#if !defined(FLAGS_NO_ATOMICS) && !defined(__cplusplus) && \
+    (__STDC_VERSION__ < 201112L || defined(__STDC_NO_ATOMICS__))
+#define FLAGS_NO_ATOMICS
+#endif
+
+#ifndef FLAGS_NO_ATOMICS
+// Storage of the atomic flags, see flagSetAtomicIntVar. Values are replaced
+// with a single store, so other threads could read them with flagLoad*
+// while the flag set parses or overrides them.
+#ifdef __cplusplus
+#include <atomic>
+typedef std::atomic<bool> FlagAtomicBool;
+typedef std::atomic<char*> FlagAtomicString;
+typedef std::atomic<int> FlagAtomicInt;
+typedef std::atomic<float> FlagAtomicFloat;
+typedef std::atomic<double> FlagAtomicDouble;
+typedef std::atomic<time_t> FlagAtomicTime;
+typedef std::atomic<int64_t> FlagAtomicInt64;
+typedef std::atomic<uint64_t> FlagAtomicUint64;
+typedef std::atomic<size_t> FlagAtomicSize;
+# define FLAGS_ATOMIC_LOAD(src, order) (src)->load(std::memory_order_##order)
+# define FLAGS_ATOMIC_STORE(dst, v, order) (dst)->store(v, std::memory_order_##order)
+# define FLAGS_ATOMIC(type) std::atomic<type>
+# define FLAGS_ATOMIC_ADD(dst, v, order) (dst)->fetch_add(v, std::memory_order_##order)
+# define FLAGS_ATOMIC_SUB(dst, v, order) (dst)->fetch_sub(v, std::memory_order_##order)
+#else
+#include <stdatomic.h>
+typedef _Atomic(bool) FlagAtomicBool;
+typedef _Atomic(char*) FlagAtomicString;
+typedef _Atomic(int) FlagAtomicInt;
+typedef _Atomic(float) FlagAtomicFloat;
+typedef _Atomic(double) FlagAtomicDouble;
+typedef _Atomic(time_t) FlagAtomicTime;
+typedef _Atomic(int64_t) FlagAtomicInt64;
+typedef _Atomic(uint64_t) FlagAtomicUint64;
+typedef _Atomic(size_t) FlagAtomicSize;
+# define FLAGS_ATOMIC_LOAD(src, order) atomic_load_explicit(src, memory_order_##order)
+# define FLAGS_ATOMIC_STORE(dst, v, order) atomic_store_explicit(dst, v, memory_order_##order)
+# define FLAGS_ATOMIC(type) _Atomic(type)
+# define FLAGS_ATOMIC_ADD(dst, v, order) atomic_fetch_add_explicit(dst, v, memory_order_##order)
+# define FLAGS_ATOMIC_SUB(dst, v, order) atomic_fetch_sub_explicit(dst, v, memory_order_##order)
+#endif
+
+// flagLoadBool returns value of the atomic boolean flag.
+static inline bool flagLoadBool(const FlagAtomicBool* src) {
+  return FLAGS_ATOMIC_LOAD(src, relaxed);
+}
+// flagLoadString returns value of the atomic string flag.
+// String is loaded with acquire order, so its characters are visible as well.
+static inline char* flagLoadString(const FlagAtomicString* src) {
+  return FLAGS_ATOMIC_LOAD(src, acquire);
+}
+// flagLoadInt returns value of the atomic int flag.
+static inline int flagLoadInt(const FlagAtomicInt* src) {
+  return FLAGS_ATOMIC_LOAD(src, relaxed);
+}
+// flagLoadFloat returns value of the atomic float flag.
+static inline float flagLoadFloat(const FlagAtomicFloat* src) {
+  return FLAGS_ATOMIC_LOAD(src, relaxed);
+}
+// flagLoadDouble returns value of the atomic double flag.
+static inline double flagLoadDouble(const FlagAtomicDouble* src) {
+  return FLAGS_ATOMIC_LOAD(src, relaxed);
+}
+// flagLoadTime returns value of the atomic time_t flag.
+static inline time_t flagLoadTime(const FlagAtomicTime* src) {
+  return FLAGS_ATOMIC_LOAD(src, relaxed);
+}
+// flagLoadInt64 returns value of the atomic int64_t flag.
+static inline int64_t flagLoadInt64(const FlagAtomicInt64* src) {
+  return FLAGS_ATOMIC_LOAD(src, relaxed);
+}
+// flagLoadUint64 returns value of the atomic uint64_t flag.
+static inline uint64_t flagLoadUint64(const FlagAtomicUint64* src) {
+  return FLAGS_ATOMIC_LOAD(src, relaxed);
+}
+// flagLoadSize returns value of the atomic size_t flag.
+static inline size_t flagLoadSize(const FlagAtomicSize* src) {
+  return FLAGS_ATOMIC_LOAD(src, relaxed);
+}
+#endif
+
+// FlagCommandInit registers flags of the subcommand in fs, data is the
+// pointer passed to flagSetCommand.
+typedef void (*FlagCommandInit)(FlagSet* fs, void* data);
+
+// FlagType is the type of the flag value.
+typedef enum { 
+  FLAG_TYPE_BOOL = 0,
+  FLAG_TYPE_STRING,
+  FLAG_TYPE_INT,
+  FLAG_TYPE_FLOAT,
+  FLAG_TYPE_DOUBLE,
+  FLAG_TYPE_TIME,
+  FLAG_TYPE_INT64,
+  FLAG_TYPE_UINT64,
+  FLAG_TYPE_SIZE,
+  FLAG_TYPE_BYTES,
+} FlagType;
+
+// FlagErrorCode describes why parsing failed.
+typedef enum {
+  // No error
+  FLAG_ERROR_CODE_NONE = 0,
+  // Error that occurs when help flag is passed
+  FLAG_ERROR_CODE_HELP,
+  // Unknown flag
+  FLAG_ERROR_CODE_UNKNOWN,
+  // Missing flag value
+  FLAG_ERROR_CODE_MISSING_VALUE,
+  // Flag value is invalid
+  FLAG_ERROR_CODE_INVALID_VALUE,
+  // Failed to open config file
+  FLAG_ERROR_CODE_OPEN_CONFIG_FILE,
+  // Failed to open response file
+  FLAG_ERROR_CODE_OPEN_RESPONSE_FILE,
+  // Response file includes itself
+  FLAG_ERROR_CODE_RESPONSE_FILE_CYCLE,
+  // Field flag is set without the struct, see flagSetParseInto
+  FLAG_ERROR_CODE_FIELD_WITHOUT_TARGET,
+} FlagErrorCode;
+
+// FlagSource describes where value of the flag comes from. Sources are
+// listed in the order of precedence, value from the source never replaces
+// value from the source that follows it.
+typedef enum {
+  // Default value
+  FLAG_SOURCE_DEFAULT = 0,
+  // Configuration file
+  FLAG_SOURCE_CONFIG,
+  // Environment variable
+  FLAG_SOURCE_ENV,
+  // Command line argument
+  FLAG_SOURCE_ARGS,
+  // Value set by the program with flagSetOverride
+  FLAG_SOURCE_OVERRIDE,
+} FlagSource;
 
 #ifdef __cplusplus
 extern "C" {
@@ -53,6 +211,8 @@ extern "C" {
 void flagPrintUsage(FILE* stream);
 // flagIgnoreUnknown allows changing the parser's behavior when an unknown flag is encountered.
 void flagIgnoreUnknown(bool ignore);
+// flagEnvPrefix enables environment variables for the default flag set, see flagSetEnvPrefix.
+void flagEnvPrefix(char* prefix);
 // flagBoolVar adds boolean flag to the default flag set.
 void flagBoolVar(bool* dst, char* name, char short_name, char* description);
 // flagStringVar adds string flag to the default flag set.
@@ -65,9 +225,74 @@ void flagFloatVar(float* dst, char* name, char short_name, float default_value,
 void flagDoubleVar(double* dst, char* name, char short_name, double default_value, char* description);
 // flagTimeVar adds time_t flag to the default flag set.
 void flagTimeVar(time_t* dst, char* name, char short_name, time_t default_value, char* description);
+// flagInt64Var adds int64_t flag to the default flag set.
+void flagInt64Var(int64_t* dst, char* name, char short_name, int64_t default_value, char* description);
+// flagUint64Var adds uint64_t flag to the default flag set.
+void flagUint64Var(uint64_t* dst, char* name, char short_name, uint64_t default_value, char* description);
+// flagSizeVar adds size_t flag to the default flag set.
+void flagSizeVar(size_t* dst, char* name, char short_name, size_t default_value, char* description);
+// flagBytesVar adds byte size flag to the default flag set, see flagSetBytesVar.
+void flagBytesVar(uint64_t* dst, char* name, char short_name, uint64_t default_value, char* description);
+#ifndef FLAGS_NO_ATOMICS
+// flagAtomicBoolVar adds atomic boolean flag to the default flag set.
+void flagAtomicBoolVar(FlagAtomicBool* dst, char* name, char short_name, char* description);
+// flagAtomicStringVar adds atomic string flag to the default flag set.
+void flagAtomicStringVar(FlagAtomicString* dst, char* name, char short_name, char* default_value, char* description);
+// flagAtomicIntVar adds atomic int flag to the default flag set.
+void flagAtomicIntVar(FlagAtomicInt* dst, char* name, char short_name, int default_value, char* description);
+// flagAtomicFloatVar adds atomic float flag to the default flag set.
+void flagAtomicFloatVar(FlagAtomicFloat* dst, char* name, char short_name, float default_value, char* description);
+// flagAtomicDoubleVar adds atomic double flag to the default flag set.
+void flagAtomicDoubleVar(FlagAtomicDouble* dst, char* name, char short_name, double default_value, char* description);
+// flagAtomicTimeVar adds atomic time_t flag to the default flag set.
+void flagAtomicTimeVar(FlagAtomicTime* dst, char* name, char short_name, time_t default_value, char* description);
+// flagAtomicInt64Var adds atomic int64_t flag to the default flag set.
+void flagAtomicInt64Var(FlagAtomicInt64* dst, char* name, char short_name, int64_t default_value, char* description);
+// flagAtomicUint64Var adds atomic uint64_t flag to the default flag set.
+void flagAtomicUint64Var(FlagAtomicUint64* dst, char* name, char short_name, uint64_t default_value, char* description);
+// flagAtomicSizeVar adds atomic size_t flag to the default flag set.
+void flagAtomicSizeVar(FlagAtomicSize* dst, char* name, char short_name, size_t default_value, char* description);
+// flagAtomicBytesVar adds atomic byte size flag to the default flag set.
+void flagAtomicBytesVar(FlagAtomicUint64* dst, char* name, char short_name, uint64_t default_value, char* description);
+#endif
+// flagBoolField adds boolean flag stored at offset inside a struct to the default flag set.
+void flagBoolField(size_t offset, char* name, char short_name, char* description);
+// flagStringField adds string flag stored at offset inside a struct to the default flag set.
+void flagStringField(size_t offset, char* name, char short_name, char* default_value, char* description);
+// flagIntField adds int flag stored at offset inside a struct to the default flag set.
+void flagIntField(size_t offset, char* name, char short_name, int default_value, char* description);
+// flagFloatField adds float flag stored at offset inside a struct to the default flag set.
+void flagFloatField(size_t offset, char* name, char short_name, float default_value, char* description);
+// flagDoubleField adds double flag stored at offset inside a struct to the default flag set.
+void flagDoubleField(size_t offset, char* name, char short_name, double default_value, char* description);
+// flagTimeField adds time_t flag stored at offset inside a struct to the default flag set.
+void flagTimeField(size_t offset, char* name, char short_name, time_t default_value, char* description);
+// flagInt64Field adds int64_t flag stored at offset inside a struct to the default flag set.
+void flagInt64Field(size_t offset, char* name, char short_name, int64_t default_value, char* description);
+// flagUint64Field adds uint64_t flag stored at offset inside a struct to the default flag set.
+void flagUint64Field(size_t offset, char* name, char short_name, uint64_t default_value, char* description);
+// flagSizeField adds size_t flag stored at offset inside a struct to the default flag set.
+void flagSizeField(size_t offset, char* name, char short_name, size_t default_value, char* description);
+// flagBytesField adds byte size flag stored at offset inside a struct to the default flag set.
+void flagBytesField(size_t offset, char* name, char short_name, uint64_t default_value, char* description);
 // flagParse attempts to parse flags from command line arguments to the default flag set.
-// NOTE: repeated call to the flagParse may result in unpredicted results.
+// NOTE: repeated call to the flagParse may result in unpredicted results,
+// call flagReset before parsing again.
 bool flagParse(int argc, char** argv);
+// flagParseInto parses flags of the default flag set, see flagSetParseInto.
+bool flagParseInto(void* base, int argc, char** argv);
+// flagArgs returns positional arguments of the default flag set, see flagSetArgs.
+int flagArgs(char*** args);
+// flagCommand adds subcommand to the default flag set, see flagSetCommand.
+void flagCommand(char* name, char* description, FlagCommandInit init, void* data);
+// flagSubcommand returns flag set of the selected subcommand, see flagSetSubcommand.
+FlagSet* flagSubcommand(void);
+// flagOverride sets value of the flag in the default flag set, see flagSetOverride.
+bool flagOverride(const char* name, char* value);
+// flagSource returns source of the flag value in the default flag set, see flagSetSource.
+FlagSource flagSource(const char* name);
+// flagReset restores default values of the default flag set, see flagSetReset.
+void flagReset(void);
 // flagPrintError prints error if any present and exits with code 1
 void flagPrintError(FILE* stream);
 
@@ -76,9 +301,15 @@ FlagSet* flagSetNew(void);
 // flagSetFree frees resources allocated by the flag set.
 void flagSetFree(FlagSet* fs);
 // flagSetPrintUsage prints usage.
-void flagSetPrintUsage(FlagSet* fs, FILE* stream);
+void flagSetPrintUsage(const FlagSet* fs, FILE* stream);
 // flagSetIgnoreUnknown allows changing the parser's behavior when an unknown flag is encountered.
 void flagSetIgnoreUnknown(FlagSet* fs, bool ignore);
+// flagSetEnvPrefix enables reading flags from environment variables named
+// PREFIX_FLAG_NAME, where FLAG_NAME is the flag name in upper case with dashes
+// replaced by underscores. Values from command line take precedence over
+// environment variables, environment variables over configuration files, and
+// configuration files over defaults. Boolean flags accept "true" or "false".
+void flagSetEnvPrefix(FlagSet* fs, char* prefix);
 // flagSetBoolVar adds boolean flag to the flag set.
 void flagSetBoolVar(FlagSet* fs, bool* dst,
     char* name, char short_name, char* description);
@@ -97,17 +328,291 @@ void flagSetDoubleVar(FlagSet* fs, double* dst,
 // flagSetTimeVar adds time_t flag to the default flag set.
 void flagSetTimeVar(FlagSet* fs, time_t* dst,
     char* name, char short_name, time_t default_value, char* description);
+// flagSetInt64Var adds int64_t flag to the flag set.
+void flagSetInt64Var(FlagSet* fs, int64_t* dst,
+    char* name, char short_name, int64_t default_value, char* description);
+// flagSetUint64Var adds uint64_t flag to the flag set, negative values are
+// not valid.
+void flagSetUint64Var(FlagSet* fs, uint64_t* dst,
+    char* name, char short_name, uint64_t default_value, char* description);
+// flagSetSizeVar adds size_t flag to the flag set, see flagSetUint64Var.
+void flagSetSizeVar(FlagSet* fs, size_t* dst,
+    char* name, char short_name, size_t default_value, char* description);
+// flagSetBytesVar adds byte size flag to the flag set. Value is a number
+// followed by the optional unit, binary KiB, MiB, GiB, TiB or decimal KB, MB,
+// GB, TB, for example "64MiB" or "2 GB". Usage shows the default in the
+// largest unit that represents it exactly.
+void flagSetBytesVar(FlagSet* fs, uint64_t* dst,
+    char* name, char short_name, uint64_t default_value, char* description);
+#ifndef FLAGS_NO_ATOMICS
+// flagSetAtomicBoolVar adds boolean flag stored in the atomic variable.
+// Values of the atomic flags are parsed aside and stored at once when
+// flagSetParse, flagSetOverride or flagSetLoad succeeds, defaults included, so
+// the variable never holds a torn or intermediate value and could be read
+// with flagLoadBool from any thread. Reading it costs as much as reading a
+// plain variable. flagSetOverride publishes only the flag it sets, a failed
+// parse or load publishes nothing and the previous values stay.
+void flagSetAtomicBoolVar(FlagSet* fs, FlagAtomicBool* dst,
+    char* name, char short_name, char* description);
+// flagSetAtomicStringVar adds string flag stored in the atomic variable.
+void flagSetAtomicStringVar(FlagSet* fs, FlagAtomicString* dst,
+    char* name, char short_name, char* default_value, char* description);
+// flagSetAtomicIntVar adds int flag stored in the atomic variable.
+void flagSetAtomicIntVar(FlagSet* fs, FlagAtomicInt* dst,
+    char* name, char short_name, int default_value, char* description);
+// flagSetAtomicFloatVar adds float flag stored in the atomic variable.
+void flagSetAtomicFloatVar(FlagSet* fs, FlagAtomicFloat* dst,
+    char* name, char short_name, float default_value, char* description);
+// flagSetAtomicDoubleVar adds double flag stored in the atomic variable.
+void flagSetAtomicDoubleVar(FlagSet* fs, FlagAtomicDouble* dst,
+    char* name, char short_name, double default_value, char* description);
+// flagSetAtomicTimeVar adds time_t flag stored in the atomic variable.
+void flagSetAtomicTimeVar(FlagSet* fs, FlagAtomicTime* dst,
+    char* name, char short_name, time_t default_value, char* description);
+// flagSetAtomicInt64Var adds int64_t flag stored in the atomic variable.
+void flagSetAtomicInt64Var(FlagSet* fs, FlagAtomicInt64* dst,
+    char* name, char short_name, int64_t default_value, char* description);
+// flagSetAtomicUint64Var adds uint64_t flag stored in the atomic variable.
+void flagSetAtomicUint64Var(FlagSet* fs, FlagAtomicUint64* dst,
+    char* name, char short_name, uint64_t default_value, char* description);
+// flagSetAtomicSizeVar adds size_t flag stored in the atomic variable.
+void flagSetAtomicSizeVar(FlagSet* fs, FlagAtomicSize* dst,
+    char* name, char short_name, size_t default_value, char* description);
+// flagSetAtomicBytesVar adds byte size flag stored in the atomic variable.
+void flagSetAtomicBytesVar(FlagSet* fs, FlagAtomicUint64* dst,
+    char* name, char short_name, uint64_t default_value, char* description);
+#endif
+// flagSetBoolField adds boolean flag stored at offset inside a struct, for
+// example offsetof(Options, verbose). Field flags are filled by flagSetParseInto.
+void flagSetBoolField(FlagSet* fs, size_t offset,
+    char* name, char short_name, char* description);
+// flagSetStringField adds string flag stored at offset inside a struct.
+void flagSetStringField(FlagSet* fs, size_t offset,
+    char* name, char short_name, char* default_value, char* description);
+// flagSetIntField adds int flag stored at offset inside a struct.
+void flagSetIntField(FlagSet* fs, size_t offset,
+    char* name, char short_name, int default_value, char* description);
+// flagSetFloatField adds float flag stored at offset inside a struct.
+void flagSetFloatField(FlagSet* fs, size_t offset,
+    char* name, char short_name, float default_value, char* description);
+// flagSetDoubleField adds double flag stored at offset inside a struct.
+void flagSetDoubleField(FlagSet* fs, size_t offset,
+    char* name, char short_name, double default_value, char* description);
+// flagSetTimeField adds time_t flag stored at offset inside a struct.
+void flagSetTimeField(FlagSet* fs, size_t offset,
+    char* name, char short_name, time_t default_value, char* description);
+// flagSetInt64Field adds int64_t flag stored at offset inside a struct.
+void flagSetInt64Field(FlagSet* fs, size_t offset,
+    char* name, char short_name, int64_t default_value, char* description);
+// flagSetUint64Field adds uint64_t flag stored at offset inside a struct.
+void flagSetUint64Field(FlagSet* fs, size_t offset,
+    char* name, char short_name, uint64_t default_value, char* description);
+// flagSetSizeField adds size_t flag stored at offset inside a struct.
+void flagSetSizeField(FlagSet* fs, size_t offset,
+    char* name, char short_name, size_t default_value, char* description);
+// flagSetBytesField adds byte size flag stored at offset inside a struct.
+void flagSetBytesField(FlagSet* fs, size_t offset,
+    char* name, char short_name, uint64_t default_value, char* description);
+// flagSetCommand adds subcommand to the flag set. When the first positional
+// argument is the name of the subcommand, its flag set is created, init
+// registers flags in it and the rest of the arguments are parsed by it.
+// Flags of subcommands that are not selected are never registered.
+void flagSetCommand(FlagSet* fs, char* name, char* description, FlagCommandInit init, void* data);
+// flagSetSubcommand returns flag set of the subcommand selected by the last
+// parse or NULL. Name of the subcommand is the program name of its flag set.
+// NOTE: subcommands are selected only by flagSetParse, contexts treat them as
+// positional arguments.
+FlagSet* flagSetSubcommand(const FlagSet* fs);
 // flagSetParse attempts to parse flags from command line arguments.
-// NOTE: repeated call to the flagParse may result in unpredicted results.
+// Long flags are written as --name value or --name=value, short flags as
+// -p value or -p8080, and boolean short flags could be combined as -abc.
+// Arguments that are not flags and all arguments after "--" are positional,
+// see flagSetArgs.
+// NOTE: positional arguments are moved in place, so order of argv changes.
+// Argument of the form @file is replaced by arguments read from the file,
+// separated by whitespace. Single and double quotes group characters,
+// backslash escapes the next character and # starts a comment that lasts until
+// the end of the line. Response files could reference other response files.
+// NOTE: repeated call to the flagParse may result in unpredicted results,
+// call flagSetReset before parsing again.
 bool flagSetParse(FlagSet* fs, int argc, char** argv);
+// flagSetParseInto works as flagSetParse, but field flags are stored into the
+// struct pointed by base. Fields are set to their defaults before parsing, so
+// the same flag set could fill any number of structs.
+// Setting a field flag without the struct, for example with flagSetParse,
+// fails with FLAG_ERROR_CODE_FIELD_WITHOUT_TARGET.
+bool flagSetParseInto(FlagSet* fs, void* base, int argc, char** argv);
+// flagSetArgs returns number of positional arguments of the last parse and
+// points args to them. Positional arguments are moved in place to the front
+// of argv, right after the program name, so args is argv + 1 unless response
+// files contributed positional arguments, then they are collected into memory
+// owned by the flag set. Arguments after "--" and values of unknown flags when
+// they are ignored are positional as well.
+int flagSetArgs(const FlagSet* fs, char*** args);
+// flagSetOverride sets value of the flag by its long name. Overridden value
+// takes precedence over all other sources until flagSetReset, so it could be
+// set before or after parsing. String values are copied, so value could be
+// freed once the function returns. Returns false if the flag is unknown, bound
+// to a struct field or the value is not valid.
+bool flagSetOverride(FlagSet* fs, const char* name, char* value);
+// flagSetSource returns source of the flag value after the last parse.
+FlagSource flagSetSource(const FlagSet* fs, const char* name);
+// flagSetReset restores default values of all flags and clears the error so
+// the flag set could parse again. Registered flags and memory are reused,
+// strings previously parsed from configuration files become invalid.
+// Atomic flags keep their values until the next parse publishes new ones,
+// only parsed atomic strings are restored to defaults at once.
+void flagSetReset(FlagSet* fs);
 // flagSetPrintError prints error if any present and exits with code 1
 void flagSetPrintError(FlagSet* fs, FILE* stream);
 
+// flagContextNew returns new parse context for the flag set with default values.
+// Context holds values and errors of the parse, so many contexts could parse
+// concurrently against one flag set without locks. Destinations passed to
+// flagSet*Var are not used by contexts and may be NULL.
+// NOTE: flag set must not be modified while it has contexts.
+FlagContext* flagContextNew(const FlagSet* fs);
+// flagContextFree frees resources allocated by the context.
+void flagContextFree(FlagContext* ctx);
+// flagContextReset restores default values and clears the error, see flagSetReset.
+void flagContextReset(FlagContext* ctx);
+// flagContextParse attempts to parse flags from command line arguments into the context.
+bool flagContextParse(FlagContext* ctx, int argc, char** argv);
+// flagContextParseInto works as flagContextParse, but field flags are stored
+// into the struct pointed by base, see flagSetParseInto.
+bool flagContextParseInto(FlagContext* ctx, void* base, int argc, char** argv);
+// flagContextArgs returns number of positional arguments of the last parse
+// and points args to them, see flagSetArgs.
+int flagContextArgs(const FlagContext* ctx, char*** args);
+// flagContextOverride sets value of the flag in the context, see flagSetOverride.
+bool flagContextOverride(FlagContext* ctx, const char* name, char* value);
+// flagContextSource returns source of the flag value in the context.
+FlagSource flagContextSource(const FlagContext* ctx, const char* name);
+// flagContextError returns error code of the last parse.
+FlagErrorCode flagContextError(const FlagContext* ctx);
+// flagContextErrorFlag returns name of the flag where error occurred.
+const char* flagContextErrorFlag(const FlagContext* ctx);
+// flagContextPrintError prints error if any present and exits with code 1
+void flagContextPrintError(const FlagContext* ctx, FILE* stream);
+// flagContextBool returns value of the boolean flag.
+bool flagContextBool(const FlagContext* ctx, const char* name);
+// flagContextString returns value of the string flag.
+char* flagContextString(const FlagContext* ctx, const char* name);
+// flagContextInt returns value of the int flag.
+int flagContextInt(const FlagContext* ctx, const char* name);
+// flagContextFloat returns value of the float flag.
+float flagContextFloat(const FlagContext* ctx, const char* name);
+// flagContextDouble returns value of the double flag.
+double flagContextDouble(const FlagContext* ctx, const char* name);
+// flagContextTime returns value of the time_t flag.
+time_t flagContextTime(const FlagContext* ctx, const char* name);
+// flagContextInt64 returns value of the int64_t flag.
+int64_t flagContextInt64(const FlagContext* ctx, const char* name);
+// flagContextUint64 returns value of the uint64_t flag.
+uint64_t flagContextUint64(const FlagContext* ctx, const char* name);
+// flagContextSize returns value of the size_t flag.
+size_t flagContextSize(const FlagContext* ctx, const char* name);
+// flagContextBytes returns value of the byte size flag.
+uint64_t flagContextBytes(const FlagContext* ctx, const char* name);
+
+#ifndef FLAGS_NO_ATOMICS
+// flagContextFreeze turns the parsed context into the immutable view of its
+// values and takes ownership of the context. The caller holds the only
+// reference to the view.
+FlagView* flagContextFreeze(FlagContext* ctx);
+// flagSetView returns view of the current values of the flag set. Strings are
+// copied, so the view outlives flagSetReset.
+// NOTE: flags bound to struct fields have default values in the view.
+FlagView* flagSetView(const FlagSet* fs);
+// flagViewContext returns context of the view, values are read with
+// flagContext* functions and must not be modified.
+const FlagContext* flagViewContext(const FlagView* view);
+// flagViewRetain adds reference to the view and returns it.
+FlagView* flagViewRetain(FlagView* view);
+// flagViewRelease drops reference to the view, view is freed when the last
+// reference is dropped.
+void flagViewRelease(FlagView* view);
+// flagSetPublish makes the view current for flagSetAcquire and takes the
+// caller's reference to it. Previous view is released once readers that are
+// acquiring it hold their references, it is freed when they release them.
+// Only one thread may publish at a time.
+void flagSetPublish(FlagSet* fs, FlagView* view);
+// flagSetAcquire returns reference to the current view of the flag set or
+// NULL if nothing is published. It never waits for the publisher, so every
+// request could acquire the view and see one generation of values.
+FlagView* flagSetAcquire(FlagSet* fs);
+#endif
+
+// flagSourceName returns human readable name of the source.
+const char* flagSourceName(FlagSource source);
+
+// flagSetSave writes values of the flags and their sources into the binary
+// snapshot. Snapshot is bound to the flag set by the hash of the names and
+// types of the flags and uses native byte order, so it is meant as a local
+// cache rather than an exchange format.
+// NOTE: flags bound to struct fields are not saved.
+bool flagSetSave(const FlagSet* fs, const char* filename);
+// flagSetLoad loads values from the snapshot written by flagSetSave keeping
+// their sources, strings point into the mapped snapshot until flagSetReset.
+// Returns false if the snapshot could not be read or was written for
+// different flags.
+bool flagSetLoad(FlagSet* fs, const char* filename);
+
+// flagParseValue converts value to the given flag type and stores result in dst.
+// Boolean values are accepted as "true" or "false".
+// Returns false if value is not valid for the type.
+bool flagParseValue(FlagType type, void* dst, char* value);
+
 #ifdef WITH_INI
 // flagConfig adds flag for the configuration file.
 void flagConfig(char* name, char short_name, char* description);
 // flagSetConfig adds flag for the config.
 void flagSetConfig(FlagSet* fs, char* name, char short_name, char* description);
+// flagSetCompileConfig parses the configuration file and writes its values
+// into the snapshot next to it, named with FLAGS_SNAPSHOT_SUFFIX. When the
+// configuration file is loaded later, the snapshot is used instead of
+// parsing it, unless size or modification time of the file changed since or
+// the snapshot was written for different flags.
+// NOTE: changes of files included by the configuration file are not tracked.
+bool flagSetCompileConfig(const FlagSet* fs, const char* filename);
+
+#if defined(__linux__) && !defined(FLAGS_NO_ATOMICS)
+// FlagWatch reloads the configuration file when it changes.
+typedef struct FlagWatch FlagWatch;
+
+// flagWatchNew starts watching the configuration file with inotify and loads
+// it. Values are parsed into a context that readers never see and published
+// at once when the whole file is parsed, so readers on other threads never
+// block and never observe a half-applied file. Published values come from
+// the file and defaults only, the command line and environment are not
+// consulted. Returns NULL if the file could not be watched, errors of the
+// initial load are reported by flagWatchError.
+// NOTE: files included by the configuration file are not watched.
+FlagWatch* flagWatchNew(const FlagSet* fs, const char* filename);
+// flagWatchFree stops watching and frees resources of the watch.
+void flagWatchFree(FlagWatch* watch);
+// flagWatchFd returns inotify descriptor of the watch that becomes readable
+// when the directory of the file changes, for use with poll or epoll.
+int flagWatchFd(const FlagWatch* watch);
+// flagWatchPoll waits up to timeout_ms milliseconds, -1 for no limit, for the
+// file to be written or replaced and reloads it. Returns true if new values
+// were published. Only one thread may poll or reload the watch.
+bool flagWatchPoll(FlagWatch* watch, int timeout_ms);
+// flagWatchReload parses the file and publishes its values. If the file is
+// not valid, previous values stay published and false is returned.
+bool flagWatchReload(FlagWatch* watch);
+// flagWatchError returns error code of the last reload.
+FlagErrorCode flagWatchError(const FlagWatch* watch);
+// flagWatchErrorFlag returns name of the flag where the last reload failed.
+const char* flagWatchErrorFlag(const FlagWatch* watch);
+// flagWatchVersion returns number of reloads published so far.
+unsigned long flagWatchVersion(const FlagWatch* watch);
+// flagWatchAcquire returns reference to the view of the last published
+// reload, defaults before the file is loaded, see flagSetAcquire. Values,
+// strings included, stay valid until the view is released, no matter how
+// many reloads are published meanwhile.
+FlagView* flagWatchAcquire(FlagWatch* watch);
+#endif
 #endif
 
 #ifdef __cplusplus
@@ -120,6 +625,15 @@ void flagSetConfig(FlagSet* fs, char* name, char short_name, char* description);
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <float.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 
 #ifdef __cplusplus
@@ -129,18 +643,10 @@ void flagSetConfig(FlagSet* fs, char* name, char short_name, char* description);
 #endif
 
 
-// @todo: add more types 
-typedef enum { 
-  FLAG_TYPE_BOOL = 0,
-  FLAG_TYPE_STRING,
-  FLAG_TYPE_INT,
-  FLAG_TYPE_FLOAT,
-  FLAG_TYPE_DOUBLE,
-  FLAG_TYPE_TIME,
-} FlagType;
-
 // Union type that will store flag value
 typedef union {
+  // FLAG_TYPE_BOOL
+  bool as_bool;
   // FLAG_TYPE_STRING
   char* as_string;
   // FLAG_TYPE_INT
@@ -151,8 +657,16 @@ typedef union {
   double as_double;
   // FLAG_TYPE_TIME
   time_t as_time_t;
+  // FLAG_TYPE_INT64
+  int64_t as_int64;
+  // FLAG_TYPE_UINT64, FLAG_TYPE_BYTES
+  uint64_t as_uint64;
+  // FLAG_TYPE_SIZE
+  size_t as_size;
 } FlagValue;
 
+#define FLAGS_NO_OFFSET SIZE_MAX
+
 // Flag contains information about singular flag.
 typedef struct {
   // Type of flag
@@ -165,31 +679,136 @@ typedef struct {
   char* description;
   // Value pointer
   void* ptr;
+  // Set if ptr points to the atomic storage.
+  bool atomic;
+  // Offset of the value inside the struct passed to flagSetParseInto,
+  // FLAGS_NO_OFFSET for flags that are stored to ptr.
+  size_t offset;
   // Default value of the flag
   FlagValue default_value;
 } Flag;
 
-typedef enum {
-  // No error
-  FLAG_ERROR_CODE_NONE = 0,
-  // Error that occurs when help flag is passed
-  FLAG_ERROR_CODE_HELP,
-  // Unknown flag
-  FLAG_ERROR_CODE_UNKNOWN,
-  // Missing flag value
-  FLAG_ERROR_CODE_MISSING_VALUE,
-  // Flag value is invalid
-  FLAG_ERROR_CODE_INVALID_VALUE,
-  // Failed to open config file
-  FLAG_ERROR_CODE_OPEN_CONFIG_FILE,
-} FlagErrorCode;
+// FlagArenaBlock is a chunk of memory owned by the arena.
+typedef struct FlagArenaBlock {
+  // Next block in the list
+  struct FlagArenaBlock* next;
+  // Number of used bytes
+  size_t len;
+  // Number of bytes available after the header
+  size_t cap;
+} FlagArenaBlock;
+
+// FlagArena is a bump allocator, everything allocated from it is released
+// at once.
+typedef struct {
+  // Current block, older blocks are linked through next
+  FlagArenaBlock* head;
+  // Blocks released by arenaReset that could be reused
+  FlagArenaBlock* spare;
+} FlagArena;
+
+// FlagMapping is a private memory mapping of the file.
+typedef struct {
+  // Start of the mapping
+  char* ptr;
+  // Size of the mapping
+  size_t len;
+} FlagMapping;
+
+// FlagContext contains state of a single parse.
+struct FlagContext {
+  // Flag set that is parsed
+  const FlagSet* fs;
+  // Values of the flags in the order of registration, NULL means that values
+  // are stored to the destinations of the flags.
+  FlagValue* values;
+  // Struct that receives values of the field flags during flagSetParseInto,
+  // NULL otherwise.
+  char* base;
+  // Error code
+  FlagErrorCode error_code;
+  // Name of the flag where error occurred
+  char error_flag_name[FLAGS_FLAG_MAX_LEN];
+  // Arena that owns strings duplicated while parsing.
+  FlagArena arena;
+  // Offset of the local standard time from UTC in seconds, resolved once per
+  // parse, FLAGS_TZ_UNRESOLVED until then.
+  long tz_offset;
+  // Set when "--" is parsed, arguments after it are not flags.
+  bool terminated;
+  // Flag set that owns the context and selects subcommands, NULL for
+  // contexts created by flagContextNew.
+  FlagSet* owner;
+  // Source of the value of every flag, see FlagSource.
+  unsigned char* sources;
+  // Number of flags that fit into the sources array.
+  int sources_cap;
+  // Values of the atomic flags until they are published, allocated along
+  // with sources for contexts that store values to the destinations.
+  FlagValue* staged;
+  // Positional arguments, point either into argv or to args_buf.
+  char** args;
+  // Number of positional arguments.
+  int args_len;
+  // Storage for positional arguments that do not fit into argv.
+  char** args_buf;
+  // Number of arguments that fit into args_buf.
+  int args_cap;
+
+  // Memory mapped response files, arguments read from them point into them.
+  FlagMapping* mappings;
+  // Number of mapped response files.
+  int mappings_len;
+  // Number of response files that fit into the mappings array.
+  int mappings_cap;
+
+#ifdef WITH_INI
+  // Configuration files named on the command line, they are loaded after
+  // the command line and environment.
+  char** config_files;
+  // Number of configuration files to load.
+  int config_files_len;
+  // Number of configuration files that fit into the config_files array.
+  int config_files_cap;
+  // Memory mapped configuration files, string values point into them.
+  struct IniParser** configs;
+  // Number of mapped configuration files.
+  int configs_len;
+  // Number of configuration files that fit into the configs array.
+  int configs_cap;
+#endif
+};
+
+// FlagCommand contains information about subcommand.
+typedef struct {
+  // Subcommand name
+  char* name;
+  // Subcommand description
+  char* description;
+  // Callback that registers flags of the subcommand
+  FlagCommandInit init;
+  // User data passed to init
+  void* data;
+  // Flag set of the subcommand, created when the subcommand is selected.
+  FlagSet* fs;
+} FlagCommand;
+
+#ifndef FLAGS_NO_ATOMICS
+// FlagViewSlots publishes views to readers, see flagSetPublish.
+typedef struct {
+  // Slots of the published views, current one is views[current].
+  FLAGS_ATOMIC(FlagView*) views[2];
+  // Number of readers that are acquiring the view of every slot.
+  FLAGS_ATOMIC(unsigned long) pins[2];
+  // Slot of the current view.
+  FLAGS_ATOMIC(int) current;
+} FlagViewSlots;
+#endif
 
 // FlagSet contains list of registered flags.
 struct FlagSet {
   // Number of flags
   int flags_len;
-  // Error code
-  FlagErrorCode error_code;
 
 #ifdef WITH_INI
   // Name for the config flag
@@ -202,27 +821,232 @@ struct FlagSet {
 
   // Should we ignore unknown flags?
   bool ignore_unknown;
+  // Prefix of environment variables, NULL if they are not read.
+  char* env_prefix;
 
-  // Name of the flag where error occurred
-  char error_flag_name[FLAGS_FLAG_MAX_LEN];
   // Registered flags.
-  Flag flags[FLAGS_MAX];
+  Flag* flags;
+  // Number of flags that fit into the allocated storage.
+  int flags_cap;
+  // Open addressing hash index over long names of the registered flags with
+  // flags_cap * 2 slots. Each slot stores position of the flag plus one,
+  // zero means empty slot.
+  int* index;
+  // Short name table, maps character to the position of the flag plus one.
+  int short_index[256];
+
+  // Registered subcommands.
+  FlagCommand* commands;
+  // Number of subcommands.
+  int commands_len;
+  // Number of subcommands that fit into the allocated storage.
+  int commands_cap;
+  // Open addressing hash index over names of the subcommands with
+  // commands_cap * 2 slots, see index.
+  int* commands_index;
+  // Subcommand selected by the last parse or NULL.
+  FlagCommand* command;
+
+  // State of the parse that stores values to the destinations of the flags.
+  FlagContext ctx;
+
+#ifndef FLAGS_NO_ATOMICS
+  // Views published by flagSetPublish.
+  FlagViewSlots published;
+#endif
+};
+
+#ifndef FLAGS_NO_ATOMICS
+// FlagView is an immutable reference counted set of values.
+struct FlagView {
+  // Context that owns values
+  FlagContext* ctx;
+  // Number of references
+  FLAGS_ATOMIC(unsigned long) refs;
 };
 
+// slotsRelease releases published views, readers keep their references.
+static void slotsRelease(FlagViewSlots* slots);
+#endif
+
+#define FLAGS_TZ_UNRESOLVED LONG_MIN
+
+#ifdef WITH_INI
+// freeConfigs closes configuration files retained by the context.
+static void freeConfigs(FlagContext* ctx);
+#endif
+
+#define FLAGS_ARENA_ALIGN (sizeof(void*) * 2)
+// Size of the block header rounded up to the alignment.
+#define FLAGS_ARENA_HEADER \
+  ((sizeof(FlagArenaBlock) + FLAGS_ARENA_ALIGN - 1) & ~(FLAGS_ARENA_ALIGN - 1))
+
+// arenaAlloc returns size bytes of memory that live until arenaFree.
+static void* arenaAlloc(FlagArena* arena, size_t size) {
+  size = (size + FLAGS_ARENA_ALIGN - 1) & ~(FLAGS_ARENA_ALIGN - 1);
+
+  FlagArenaBlock* block = arena->head;
+  if (block == NULL || block->cap - block->len < size) {
+    FlagArenaBlock** spare = &arena->spare;
+    while (*spare != NULL && (*spare)->cap < size) {
+      spare = &(*spare)->next;
+    }
+
+    if (*spare != NULL) {
+      block  = *spare;
+      *spare = block->next;
+    } else {
+      size_t cap = size > FLAGS_ARENA_BLOCK_SIZE ? size : FLAGS_ARENA_BLOCK_SIZE;
+      block = CAST(FlagArenaBlock*, malloc(FLAGS_ARENA_HEADER + cap));
+      block->cap = cap;
+    }
+
+    block->len  = 0;
+    block->next = arena->head;
+    arena->head = block;
+  }
+
+  char* ptr = (char*)block + FLAGS_ARENA_HEADER + block->len;
+  block->len += size;
+
+  return ptr;
+}
+
+// arenaReset makes all memory allocated from the arena available again
+// without returning it to the system.
+static void arenaReset(FlagArena* arena) {
+  while (arena->head != NULL) {
+    FlagArenaBlock* block = arena->head;
+    arena->head  = block->next;
+    block->next  = arena->spare;
+    arena->spare = block;
+  }
+}
+
+// arenaFree releases all memory allocated from the arena.
+static void arenaFree(FlagArena* arena) {
+  arenaReset(arena);
+
+  FlagArenaBlock* block = arena->spare;
+  while (block != NULL) {
+    FlagArenaBlock* next = block->next;
+    free(block);
+    block = next;
+  }
+  arena->spare = NULL;
+}
+
 FlagSet* flagSetNew(void) {
-  FlagSet* fs = (FlagSet*)malloc(sizeof(FlagSet));
-  memset(fs, 0, sizeof(FlagSet));
-  return fs;
+  // @note: all zero bytes are the empty slots of published views as well.
+  return CAST(FlagSet*, calloc(1, sizeof(FlagSet)));
+}
+
+// freeMappings unmaps response files retained by the context.
+static void freeMappings(FlagContext* ctx) {
+  for (int i = 0; i < ctx->mappings_len; i++) {
+    munmap(ctx->mappings[i].ptr, ctx->mappings[i].len);
+  }
+  ctx->mappings_len = 0;
+}
+
+// retainMapping keeps mapping alive until the context is reset or freed.
+static void retainMapping(FlagContext* ctx, char* ptr, size_t len) {
+  if (ctx->mappings_len == ctx->mappings_cap) {
+    ctx->mappings_cap = ctx->mappings_cap > 0 ? ctx->mappings_cap * 2 : 4;
+    ctx->mappings     = CAST(FlagMapping*,
+        realloc(ctx->mappings, ctx->mappings_cap * sizeof(FlagMapping)));
+  }
+  ctx->mappings[ctx->mappings_len].ptr = ptr;
+  ctx->mappings[ctx->mappings_len].len = len;
+  ctx->mappings_len++;
+}
+
+// contextRelease frees resources owned by the context.
+static void contextRelease(FlagContext* ctx) {
+  freeMappings(ctx);
+  free(ctx->mappings);
+#ifdef WITH_INI
+  freeConfigs(ctx);
+  free(ctx->configs);
+  free(ctx->config_files);
+#endif
+  arenaFree(&ctx->arena);
+  free(ctx->values);
+  free(ctx->args_buf);
+  free(ctx->sources);
+  free(ctx->staged);
+}
+
+// contextClear clears the error and releases everything the previous parse
+// allocated, keeping memory for the next parse.
+static void contextClear(FlagContext* ctx) {
+  ctx->error_code         = FLAG_ERROR_CODE_NONE;
+  ctx->error_flag_name[0] = '\0';
+  ctx->args               = NULL;
+  ctx->args_len           = 0;
+
+  if (ctx->sources != NULL) {
+    memset(ctx->sources, FLAG_SOURCE_DEFAULT, ctx->sources_cap);
+  }
+
+  freeMappings(ctx);
+#ifdef WITH_INI
+  freeConfigs(ctx);
+#endif
+  arenaReset(&ctx->arena);
 }
 
 void flagSetFree(FlagSet* fs) {
+  for (int i = 0; i < fs->commands_len; i++) {
+    if (fs->commands[i].fs != NULL) {
+      flagSetFree(fs->commands[i].fs);
+    }
+  }
+  free(fs->commands);
+  free(fs->commands_index);
+
+#ifndef FLAGS_NO_ATOMICS
+  slotsRelease(&fs->published);
+#endif
+
+  contextRelease(&fs->ctx);
+  free(fs->flags);
+  free(fs->index);
   free(fs);
 }
 
-void flagSetPrintUsage(FlagSet* fs, FILE* stream) {
-  static char buf[512] = { 0 };
+// formatBytes writes size in the largest unit that represents it exactly.
+static void formatBytes(uint64_t value, char* buf, int size) {
+  static const char units[] = "KMGTPE";
 
-  Flag* flag;
+  // Binary and decimal units are tried and the shorter number is printed.
+  uint64_t binary      = value;
+  int      binary_unit = 0;
+  while (binary != 0 && binary % 1024 == 0 && binary_unit < 6) {
+    binary /= 1024;
+    binary_unit++;
+  }
+
+  uint64_t decimal      = value;
+  int      decimal_unit = 0;
+  while (decimal != 0 && decimal % 1000 == 0 && decimal_unit < 6) {
+    decimal /= 1000;
+    decimal_unit++;
+  }
+
+  if (binary_unit == 0 && decimal_unit == 0) {
+    snprintf(buf, size, "%" PRIu64 "B", value);
+  } else if (binary_unit > 0 && (decimal_unit == 0 || binary <= decimal)) {
+    snprintf(buf, size, "%" PRIu64 "%ciB", binary, units[binary_unit - 1]);
+  } else {
+    snprintf(buf, size, "%" PRIu64 "%cB", decimal, units[decimal_unit - 1]);
+  }
+}
+
+void flagSetPrintUsage(const FlagSet* fs, FILE* stream) {
+  char buf[512] = { 0 };
+
+  const Flag* flag;
   // length of the current flag name
   int len          = 0;
 #ifdef WITH_INI
@@ -294,328 +1118,2545 @@ void flagSetPrintUsage(FlagSet* fs, FILE* stream) {
           fprintf(stream, " (default: %s)", buf);
         }
       } break;
+    case FLAG_TYPE_INT64:
+      {
+        fprintf(stream, " (default: %" PRId64 ")", flag->default_value.as_int64);
+      } break;
+    case FLAG_TYPE_UINT64:
+      {
+        fprintf(stream, " (default: %" PRIu64 ")", flag->default_value.as_uint64);
+      } break;
+    case FLAG_TYPE_SIZE:
+      {
+        fprintf(stream, " (default: %zu)", flag->default_value.as_size);
+      } break;
+    case FLAG_TYPE_BYTES:
+      {
+        formatBytes(flag->default_value.as_uint64, buf, 512);
+        fprintf(stream, " (default: %s)", buf);
+      } break;
     }
     fprintf(stream, "\n");
   }
   fprintf(stream, "  -h, --%-*s Show this help message\n", max_flag_len, "help");
 
   fprintf(stream, "\n");
-}
-
-void flagSetIgnoreUnknown(FlagSet* fs, bool ignore) {
-  fs->ignore_unknown = ignore;
-}
-
 
-static Flag* flagMake(FlagSet* fs, void* dst, FlagType type, 
-    char* name, char short_name, char* description) {
-  assert(fs->flags_len < FLAGS_MAX);
-  Flag* flag = fs->flags + fs->flags_len;
+  if (fs->commands_len > 0) {
+    int max_command_len = 0;
+    for (int i = 0; i < fs->commands_len; i++) {
+      if ((len = strlen(fs->commands[i].name)) > max_command_len) {
+        max_command_len = len;
+      }
+    }
 
-  flag->type        = type;
-  flag->name        = name;
-  flag->short_name  = short_name;
-  flag->description = description;
-  flag->ptr         = dst;
+    fprintf(stream, "COMMANDS\n");
+    for (int i = 0; i < fs->commands_len; i++) {
+      fprintf(stream, "  %-*s %s\n", max_command_len + 4,
+          fs->commands[i].name, fs->commands[i].description);
+    }
 
-  fs->flags_len++;
-  return flag;
+    fprintf(stream, "\n");
+  }
 }
 
-void flagSetBoolVar(FlagSet* fs, bool* dst,
-    char* name, char short_name, char* description) {
-  flagMake(fs, dst, FLAG_TYPE_BOOL, name, short_name, description);
-  *dst = false;
+void flagSetIgnoreUnknown(FlagSet* fs, bool ignore) {
+  fs->ignore_unknown = ignore;
 }
 
-void flagSetStringVar(FlagSet* fs, char** dst,
-    char* name, char short_name, char* default_value, char* description) {
-  Flag* flag = flagMake(fs, dst, FLAG_TYPE_STRING, name, short_name, description);
-
-  flag->default_value.as_string = default_value;
-  *dst = default_value;
+void flagSetEnvPrefix(FlagSet* fs, char* prefix) {
+  fs->env_prefix = prefix;
 }
 
-void flagSetIntVar(FlagSet* fs, int* dst,
-    char* name, char short_name, int default_value, char* description) {
-  Flag* flag = flagMake(fs, dst, FLAG_TYPE_INT, name, short_name, description);
-
-  flag->default_value.as_int = default_value;
-  *dst = default_value;
+// storeValue stores value of the given type to dst.
+static void storeValue(FlagType type, void* dst, FlagValue value) {
+  switch (type) {
+    case FLAG_TYPE_BOOL:
+      *((bool*)dst) = value.as_bool;
+      break;
+    case FLAG_TYPE_STRING:
+      *((char**)dst) = value.as_string;
+      break;
+    case FLAG_TYPE_INT:
+      *((int*)dst) = value.as_int;
+      break;
+    case FLAG_TYPE_FLOAT:
+      *((float*)dst) = value.as_float;
+      break;
+    case FLAG_TYPE_DOUBLE:
+      *((double*)dst) = value.as_double;
+      break;
+    case FLAG_TYPE_TIME:
+      *((time_t*)dst) = value.as_time_t;
+      break;
+    case FLAG_TYPE_INT64:
+      *((int64_t*)dst) = value.as_int64;
+      break;
+    case FLAG_TYPE_UINT64:
+    case FLAG_TYPE_BYTES:
+      *((uint64_t*)dst) = value.as_uint64;
+      break;
+    case FLAG_TYPE_SIZE:
+      *((size_t*)dst) = value.as_size;
+      break;
+  }
 }
 
-void flagSetFloatVar(FlagSet* fs, float* dst,
-    char* name, char short_name, float default_value, char* description) {
-  Flag* flag = flagMake(fs, dst, FLAG_TYPE_FLOAT, name, short_name, description);
-
-  flag->default_value.as_float = default_value;
-  *dst = default_value;
+// setDefault stores default value of the flag to dst.
+static void setDefault(const Flag* flag, void* dst) {
+  if (flag->type == FLAG_TYPE_BOOL) {
+    *((bool*)dst) = false;
+    return;
+  }
+  storeValue(flag->type, dst, flag->default_value);
 }
 
-void flagSetDoubleVar(FlagSet* fs, double* dst,
-    char* name, char short_name, double default_value, char* description) {
-  Flag* flag = flagMake(fs, dst, FLAG_TYPE_DOUBLE, name, short_name, description);
-
-  flag->default_value.as_double = default_value;
-  *dst = default_value;
+#ifndef FLAGS_NO_ATOMICS
+// atomicStore stores value of the atomic flag with a single store. Strings
+// are stored with release order, so their characters are visible to readers
+// that load them with acquire order, the rest are relaxed as in flagLoad*.
+static void atomicStore(const Flag* flag, FlagValue value) {
+  switch (flag->type) {
+    case FLAG_TYPE_BOOL:
+      FLAGS_ATOMIC_STORE(CAST(FlagAtomicBool*, flag->ptr), value.as_bool, relaxed);
+      break;
+    case FLAG_TYPE_STRING:
+      FLAGS_ATOMIC_STORE(CAST(FlagAtomicString*, flag->ptr), value.as_string, release);
+      break;
+    case FLAG_TYPE_INT:
+      FLAGS_ATOMIC_STORE(CAST(FlagAtomicInt*, flag->ptr), value.as_int, relaxed);
+      break;
+    case FLAG_TYPE_FLOAT:
+      FLAGS_ATOMIC_STORE(CAST(FlagAtomicFloat*, flag->ptr), value.as_float, relaxed);
+      break;
+    case FLAG_TYPE_DOUBLE:
+      FLAGS_ATOMIC_STORE(CAST(FlagAtomicDouble*, flag->ptr), value.as_double, relaxed);
+      break;
+    case FLAG_TYPE_TIME:
+      FLAGS_ATOMIC_STORE(CAST(FlagAtomicTime*, flag->ptr), value.as_time_t, relaxed);
+      break;
+    case FLAG_TYPE_INT64:
+      FLAGS_ATOMIC_STORE(CAST(FlagAtomicInt64*, flag->ptr), value.as_int64, relaxed);
+      break;
+    case FLAG_TYPE_UINT64:
+    case FLAG_TYPE_BYTES:
+      FLAGS_ATOMIC_STORE(CAST(FlagAtomicUint64*, flag->ptr), value.as_uint64, relaxed);
+      break;
+    case FLAG_TYPE_SIZE:
+      FLAGS_ATOMIC_STORE(CAST(FlagAtomicSize*, flag->ptr), value.as_size, relaxed);
+      break;
+  }
 }
 
-void flagSetTimeVar(FlagSet* fs, time_t* dst,
+// atomicLoad returns value of the atomic flag.
+static FlagValue atomicLoad(const Flag* flag) {
+  FlagValue value;
+  memset(&value, 0, sizeof(value));
+  switch (flag->type) {
+    case FLAG_TYPE_BOOL:
+      value.as_bool = flagLoadBool(CAST(const FlagAtomicBool*, flag->ptr));
+      break;
+    case FLAG_TYPE_STRING:
+      value.as_string = flagLoadString(CAST(const FlagAtomicString*, flag->ptr));
+      break;
+    case FLAG_TYPE_INT:
+      value.as_int = flagLoadInt(CAST(const FlagAtomicInt*, flag->ptr));
+      break;
+    case FLAG_TYPE_FLOAT:
+      value.as_float = flagLoadFloat(CAST(const FlagAtomicFloat*, flag->ptr));
+      break;
+    case FLAG_TYPE_DOUBLE:
+      value.as_double = flagLoadDouble(CAST(const FlagAtomicDouble*, flag->ptr));
+      break;
+    case FLAG_TYPE_TIME:
+      value.as_time_t = flagLoadTime(CAST(const FlagAtomicTime*, flag->ptr));
+      break;
+    case FLAG_TYPE_INT64:
+      value.as_int64 = flagLoadInt64(CAST(const FlagAtomicInt64*, flag->ptr));
+      break;
+    case FLAG_TYPE_UINT64:
+    case FLAG_TYPE_BYTES:
+      value.as_uint64 = flagLoadUint64(CAST(const FlagAtomicUint64*, flag->ptr));
+      break;
+    case FLAG_TYPE_SIZE:
+      value.as_size = flagLoadSize(CAST(const FlagAtomicSize*, flag->ptr));
+      break;
+  }
+  return value;
+}
+#endif
+
+void flagSetReset(FlagSet* fs) {
+  const FlagContext* ctx = &fs->ctx;
+  for (int i = 0; i < fs->flags_len; i++) {
+    const Flag* flag = fs->flags + i;
+    if (!flag->atomic) {
+      if (flag->ptr != NULL) {
+        setDefault(flag, flag->ptr);
+      }
+      continue;
+    }
+
+#ifndef FLAGS_NO_ATOMICS
+    // @note: atomic flags keep their values until the next parse publishes
+    // new ones, except parsed strings that could live in memory freed below.
+    if (flag->type == FLAG_TYPE_STRING && i < ctx->sources_cap &&
+        ctx->sources[i] != FLAG_SOURCE_DEFAULT) {
+      atomicStore(flag, flag->default_value);
+    }
+#else
+    (void)ctx;
+#endif
+  }
+
+  if (fs->command != NULL) {
+    flagSetReset(fs->command->fs);
+    fs->command = NULL;
+  }
+
+  contextClear(&fs->ctx);
+}
+
+FlagContext* flagContextNew(const FlagSet* fs) {
+  FlagContext* ctx = CAST(FlagContext*, malloc(sizeof(FlagContext)));
+  memset(ctx, 0, sizeof(FlagContext));
+
+  ctx->fs     = fs;
+  ctx->values = CAST(FlagValue*, calloc(fs->flags_len > 0 ? fs->flags_len : 1, sizeof(FlagValue)));
+
+  flagContextReset(ctx);
+  return ctx;
+}
+
+void flagContextFree(FlagContext* ctx) {
+  contextRelease(ctx);
+  free(ctx);
+}
+
+void flagContextReset(FlagContext* ctx) {
+  for (int i = 0; i < ctx->fs->flags_len; i++) {
+    setDefault(ctx->fs->flags + i, ctx->values + i);
+  }
+
+  contextClear(ctx);
+}
+
+int flagContextArgs(const FlagContext* ctx, char*** args) {
+  *args = ctx->args;
+  return ctx->args_len;
+}
+
+int flagSetArgs(const FlagSet* fs, char*** args) {
+  return flagContextArgs(&fs->ctx, args);
+}
+
+FlagErrorCode flagContextError(const FlagContext* ctx) {
+  return ctx->error_code;
+}
+
+const char* flagContextErrorFlag(const FlagContext* ctx) {
+  return ctx->error_flag_name;
+}
+
+// flagHash returns FNV-1a hash of the first len bytes of the string.
+static unsigned int flagHash(const char* s, int len) {
+  unsigned int hash = 2166136261u;
+  for (int i = 0; i < len; i++) {
+    hash ^= CAST(unsigned char, s[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// flagIndexFind returns flag with exactly matching long name or NULL, hash
+// is flagHash of the name.
+static const Flag* flagIndexFind(const FlagSet* fs, const char* name, int len, unsigned int hash) {
+  if (fs->index == NULL) {
+    return NULL;
+  }
+
+  unsigned int mask = fs->flags_cap * 2 - 1;
+  unsigned int slot = hash & mask;
+
+  while (fs->index[slot] != 0) {
+    const Flag* item = fs->flags + fs->index[slot] - 1;
+    if (strncmp(item->name, name, len) == 0 && item->name[len] == '\0') {
+      return item;
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  return NULL;
+}
+
+// flagIndexLookup returns flag with exactly matching long name or NULL.
+static const Flag* flagIndexLookup(const FlagSet* fs, const char* name, int len) {
+  return flagIndexFind(fs, name, len, flagHash(name, len));
+}
+
+// commandLookup returns subcommand with the given name or NULL.
+static FlagCommand* commandLookup(const FlagSet* fs, const char* name) {
+  if (fs->commands_index == NULL) {
+    return NULL;
+  }
+
+  int          len  = strlen(name);
+  unsigned int mask = fs->commands_cap * 2 - 1;
+  unsigned int slot = flagHash(name, len) & mask;
+
+  while (fs->commands_index[slot] != 0) {
+    FlagCommand* item = fs->commands + fs->commands_index[slot] - 1;
+    if (strcmp(item->name, name) == 0) {
+      return item;
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  return NULL;
+}
+
+// commandIndexInsert adds subcommand at position i to the index.
+static void commandIndexInsert(FlagSet* fs, int i) {
+  char* name = fs->commands[i].name;
+  // @note: duplicate names would make one of the subcommands unreachable.
+  assert(commandLookup(fs, name) == NULL);
+
+  unsigned int mask = fs->commands_cap * 2 - 1;
+  unsigned int slot = flagHash(name, strlen(name)) & mask;
+  while (fs->commands_index[slot] != 0) {
+    slot = (slot + 1) & mask;
+  }
+  fs->commands_index[slot] = i + 1;
+}
+
+void flagSetCommand(FlagSet* fs, char* name, char* description, FlagCommandInit init, void* data) {
+  assert(init != NULL);
+
+  if (fs->commands_len == fs->commands_cap) {
+    int cap = fs->commands_cap > 0 ? fs->commands_cap * 2 : FLAGS_MIN_CAPACITY;
+
+    fs->commands     = CAST(FlagCommand*, realloc(fs->commands, cap * sizeof(FlagCommand)));
+    fs->commands_cap = cap;
+
+    free(fs->commands_index);
+    fs->commands_index = CAST(int*, calloc(cap * 2, sizeof(int)));
+    for (int i = 0; i < fs->commands_len; i++) {
+      commandIndexInsert(fs, i);
+    }
+  }
+
+  FlagCommand* command = fs->commands + fs->commands_len;
+
+  command->name        = name;
+  command->description = description;
+  command->init        = init;
+  command->data        = data;
+  command->fs          = NULL;
+
+  commandIndexInsert(fs, fs->commands_len);
+  fs->commands_len++;
+}
+
+FlagSet* flagSetSubcommand(const FlagSet* fs) {
+  return fs->command != NULL ? fs->command->fs : NULL;
+}
+
+// flagIndexInsert adds flag at position i to the long name index.
+static void flagIndexInsert(FlagSet* fs, int i) {
+  char* name = fs->flags[i].name;
+  int len    = strlen(name);
+  // @note: duplicate names would make one of the flags unreachable.
+  assert(flagIndexLookup(fs, name, len) == NULL);
+
+  unsigned int mask = fs->flags_cap * 2 - 1;
+  unsigned int slot = flagHash(name, len) & mask;
+  while (fs->index[slot] != 0) {
+    slot = (slot + 1) & mask;
+  }
+  fs->index[slot] = i + 1;
+}
+
+// flagGrow doubles the flag storage and rebuilds the long name index.
+static void flagGrow(FlagSet* fs) {
+  int cap = fs->flags_cap > 0 ? fs->flags_cap * 2 : FLAGS_MIN_CAPACITY;
+
+  fs->flags     = CAST(Flag*, realloc(fs->flags, cap * sizeof(Flag)));
+  fs->flags_cap = cap;
+
+  free(fs->index);
+  fs->index = CAST(int*, calloc(cap * 2, sizeof(int)));
+
+  for (int i = 0; i < fs->flags_len; i++) {
+    flagIndexInsert(fs, i);
+  }
+}
+
+static Flag* flagMake(FlagSet* fs, void* dst, FlagType type, 
+    char* name, char short_name, char* description) {
+  if (fs->flags_len == fs->flags_cap) {
+    flagGrow(fs);
+  }
+
+  Flag* flag = fs->flags + fs->flags_len;
+
+  flag->type        = type;
+  flag->name        = name;
+  flag->short_name  = short_name;
+  flag->description = description;
+  flag->ptr         = dst;
+  flag->atomic      = false;
+  flag->offset      = FLAGS_NO_OFFSET;
+
+  flagIndexInsert(fs, fs->flags_len);
+
+  if (short_name != 0) {
+    unsigned char slot = CAST(unsigned char, short_name);
+    // @note: duplicate short names would make one of the flags unreachable.
+    assert(fs->short_index[slot] == 0);
+    fs->short_index[slot] = fs->flags_len + 1;
+  }
+
+  fs->flags_len++;
+  return flag;
+}
+
+void flagSetBoolVar(FlagSet* fs, bool* dst,
+    char* name, char short_name, char* description) {
+  flagMake(fs, dst, FLAG_TYPE_BOOL, name, short_name, description);
+  if (dst != NULL) {
+    *dst = false;
+  }
+}
+
+void flagSetStringVar(FlagSet* fs, char** dst,
+    char* name, char short_name, char* default_value, char* description) {
+  Flag* flag = flagMake(fs, dst, FLAG_TYPE_STRING, name, short_name, description);
+
+  flag->default_value.as_string = default_value;
+  if (dst != NULL) {
+    *dst = default_value;
+  }
+}
+
+void flagSetIntVar(FlagSet* fs, int* dst,
+    char* name, char short_name, int default_value, char* description) {
+  Flag* flag = flagMake(fs, dst, FLAG_TYPE_INT, name, short_name, description);
+
+  flag->default_value.as_int = default_value;
+  if (dst != NULL) {
+    *dst = default_value;
+  }
+}
+
+void flagSetFloatVar(FlagSet* fs, float* dst,
+    char* name, char short_name, float default_value, char* description) {
+  Flag* flag = flagMake(fs, dst, FLAG_TYPE_FLOAT, name, short_name, description);
+
+  flag->default_value.as_float = default_value;
+  if (dst != NULL) {
+    *dst = default_value;
+  }
+}
+
+void flagSetDoubleVar(FlagSet* fs, double* dst,
+    char* name, char short_name, double default_value, char* description) {
+  Flag* flag = flagMake(fs, dst, FLAG_TYPE_DOUBLE, name, short_name, description);
+
+  flag->default_value.as_double = default_value;
+  if (dst != NULL) {
+    *dst = default_value;
+  }
+}
+
+void flagSetTimeVar(FlagSet* fs, time_t* dst,
     char* name, char short_name, time_t default_value, char* description) {
   Flag* flag = flagMake(fs, dst, FLAG_TYPE_TIME, name, short_name, description);
 
-  flag->default_value.as_time_t = default_value;
-  *dst = default_value;
+  flag->default_value.as_time_t = default_value;
+  if (dst != NULL) {
+    *dst = default_value;
+  }
+}
+
+void flagSetInt64Var(FlagSet* fs, int64_t* dst,
+    char* name, char short_name, int64_t default_value, char* description) {
+  Flag* flag = flagMake(fs, dst, FLAG_TYPE_INT64, name, short_name, description);
+
+  flag->default_value.as_int64 = default_value;
+  if (dst != NULL) {
+    *dst = default_value;
+  }
+}
+
+void flagSetUint64Var(FlagSet* fs, uint64_t* dst,
+    char* name, char short_name, uint64_t default_value, char* description) {
+  Flag* flag = flagMake(fs, dst, FLAG_TYPE_UINT64, name, short_name, description);
+
+  flag->default_value.as_uint64 = default_value;
+  if (dst != NULL) {
+    *dst = default_value;
+  }
+}
+
+void flagSetSizeVar(FlagSet* fs, size_t* dst,
+    char* name, char short_name, size_t default_value, char* description) {
+  Flag* flag = flagMake(fs, dst, FLAG_TYPE_SIZE, name, short_name, description);
+
+  flag->default_value.as_size = default_value;
+  if (dst != NULL) {
+    *dst = default_value;
+  }
+}
+
+void flagSetBytesVar(FlagSet* fs, uint64_t* dst,
+    char* name, char short_name, uint64_t default_value, char* description) {
+  Flag* flag = flagMake(fs, dst, FLAG_TYPE_BYTES, name, short_name, description);
+
+  flag->default_value.as_uint64 = default_value;
+  if (dst != NULL) {
+    *dst = default_value;
+  }
+}
+
+#ifndef FLAGS_NO_ATOMICS
+// publishAtomic stores value of the atomic flag, parsed by the context or
+// default.
+static void publishAtomic(const FlagSet* fs, const FlagContext* ctx, const Flag* flag) {
+  if (ctx->values != NULL || !flag->atomic) {
+    return;
+  }
+
+  int  i      = flag - fs->flags;
+  bool parsed = i < ctx->sources_cap && ctx->sources[i] != FLAG_SOURCE_DEFAULT;
+  atomicStore(flag, parsed ? ctx->staged[i] : flag->default_value);
+}
+
+// publishAtomics stores values of all atomic flags once the parse succeeded.
+static void publishAtomics(const FlagSet* fs, const FlagContext* ctx) {
+  for (int i = 0; i < fs->flags_len; i++) {
+    publishAtomic(fs, ctx, fs->flags + i);
+  }
+}
+
+// flagMakeAtomic adds flag stored in the atomic variable.
+static void flagMakeAtomic(FlagSet* fs, void* dst, FlagType type,
+    char* name, char short_name, char* description, FlagValue default_value) {
+  // @note: std::atomic and _Atomic of these types have the layout of the
+  // plain types when they are lock free.
+  assert(dst != NULL);
+
+  Flag* flag = flagMake(fs, dst, type, name, short_name, description);
+
+  flag->atomic        = true;
+  flag->default_value = default_value;
+  atomicStore(flag, default_value);
+}
+
+void flagSetAtomicBoolVar(FlagSet* fs, FlagAtomicBool* dst,
+    char* name, char short_name, char* description) {
+  FlagValue value;
+  value.as_bool = false;
+  flagMakeAtomic(fs, dst, FLAG_TYPE_BOOL, name, short_name, description, value);
+}
+
+void flagSetAtomicStringVar(FlagSet* fs, FlagAtomicString* dst,
+    char* name, char short_name, char* default_value, char* description) {
+  FlagValue value;
+  value.as_string = default_value;
+  flagMakeAtomic(fs, dst, FLAG_TYPE_STRING, name, short_name, description, value);
+}
+
+void flagSetAtomicIntVar(FlagSet* fs, FlagAtomicInt* dst,
+    char* name, char short_name, int default_value, char* description) {
+  FlagValue value;
+  value.as_int = default_value;
+  flagMakeAtomic(fs, dst, FLAG_TYPE_INT, name, short_name, description, value);
+}
+
+void flagSetAtomicFloatVar(FlagSet* fs, FlagAtomicFloat* dst,
+    char* name, char short_name, float default_value, char* description) {
+  FlagValue value;
+  value.as_float = default_value;
+  flagMakeAtomic(fs, dst, FLAG_TYPE_FLOAT, name, short_name, description, value);
+}
+
+void flagSetAtomicDoubleVar(FlagSet* fs, FlagAtomicDouble* dst,
+    char* name, char short_name, double default_value, char* description) {
+  FlagValue value;
+  value.as_double = default_value;
+  flagMakeAtomic(fs, dst, FLAG_TYPE_DOUBLE, name, short_name, description, value);
+}
+
+void flagSetAtomicTimeVar(FlagSet* fs, FlagAtomicTime* dst,
+    char* name, char short_name, time_t default_value, char* description) {
+  FlagValue value;
+  value.as_time_t = default_value;
+  flagMakeAtomic(fs, dst, FLAG_TYPE_TIME, name, short_name, description, value);
+}
+
+void flagSetAtomicInt64Var(FlagSet* fs, FlagAtomicInt64* dst,
+    char* name, char short_name, int64_t default_value, char* description) {
+  FlagValue value;
+  value.as_int64 = default_value;
+  flagMakeAtomic(fs, dst, FLAG_TYPE_INT64, name, short_name, description, value);
+}
+
+void flagSetAtomicUint64Var(FlagSet* fs, FlagAtomicUint64* dst,
+    char* name, char short_name, uint64_t default_value, char* description) {
+  FlagValue value;
+  value.as_uint64 = default_value;
+  flagMakeAtomic(fs, dst, FLAG_TYPE_UINT64, name, short_name, description, value);
+}
+
+void flagSetAtomicSizeVar(FlagSet* fs, FlagAtomicSize* dst,
+    char* name, char short_name, size_t default_value, char* description) {
+  FlagValue value;
+  value.as_size = default_value;
+  flagMakeAtomic(fs, dst, FLAG_TYPE_SIZE, name, short_name, description, value);
+}
+
+void flagSetAtomicBytesVar(FlagSet* fs, FlagAtomicUint64* dst,
+    char* name, char short_name, uint64_t default_value, char* description) {
+  FlagValue value;
+  value.as_uint64 = default_value;
+  flagMakeAtomic(fs, dst, FLAG_TYPE_BYTES, name, short_name, description, value);
+}
+#else
+static void publishAtomic(const FlagSet* fs, const FlagContext* ctx, const Flag* flag) {
+  (void)fs, (void)ctx, (void)flag;
+}
+
+static void publishAtomics(const FlagSet* fs, const FlagContext* ctx) {
+  (void)fs, (void)ctx;
+}
+#endif
+
+void flagSetBoolField(FlagSet* fs, size_t offset,
+    char* name, char short_name, char* description) {
+  Flag* flag = flagMake(fs, NULL, FLAG_TYPE_BOOL, name, short_name, description);
+
+  flag->offset = offset;
+}
+
+void flagSetStringField(FlagSet* fs, size_t offset,
+    char* name, char short_name, char* default_value, char* description) {
+  Flag* flag = flagMake(fs, NULL, FLAG_TYPE_STRING, name, short_name, description);
+
+  flag->offset                  = offset;
+  flag->default_value.as_string = default_value;
+}
+
+void flagSetIntField(FlagSet* fs, size_t offset,
+    char* name, char short_name, int default_value, char* description) {
+  Flag* flag = flagMake(fs, NULL, FLAG_TYPE_INT, name, short_name, description);
+
+  flag->offset               = offset;
+  flag->default_value.as_int = default_value;
+}
+
+void flagSetFloatField(FlagSet* fs, size_t offset,
+    char* name, char short_name, float default_value, char* description) {
+  Flag* flag = flagMake(fs, NULL, FLAG_TYPE_FLOAT, name, short_name, description);
+
+  flag->offset                 = offset;
+  flag->default_value.as_float = default_value;
+}
+
+void flagSetDoubleField(FlagSet* fs, size_t offset,
+    char* name, char short_name, double default_value, char* description) {
+  Flag* flag = flagMake(fs, NULL, FLAG_TYPE_DOUBLE, name, short_name, description);
+
+  flag->offset                  = offset;
+  flag->default_value.as_double = default_value;
+}
+
+void flagSetTimeField(FlagSet* fs, size_t offset,
+    char* name, char short_name, time_t default_value, char* description) {
+  Flag* flag = flagMake(fs, NULL, FLAG_TYPE_TIME, name, short_name, description);
+
+  flag->offset                  = offset;
+  flag->default_value.as_time_t = default_value;
+}
+
+void flagSetInt64Field(FlagSet* fs, size_t offset,
+    char* name, char short_name, int64_t default_value, char* description) {
+  Flag* flag = flagMake(fs, NULL, FLAG_TYPE_INT64, name, short_name, description);
+
+  flag->offset                = offset;
+  flag->default_value.as_int64 = default_value;
+}
+
+void flagSetUint64Field(FlagSet* fs, size_t offset,
+    char* name, char short_name, uint64_t default_value, char* description) {
+  Flag* flag = flagMake(fs, NULL, FLAG_TYPE_UINT64, name, short_name, description);
+
+  flag->offset                 = offset;
+  flag->default_value.as_uint64 = default_value;
+}
+
+void flagSetSizeField(FlagSet* fs, size_t offset,
+    char* name, char short_name, size_t default_value, char* description) {
+  Flag* flag = flagMake(fs, NULL, FLAG_TYPE_SIZE, name, short_name, description);
+
+  flag->offset               = offset;
+  flag->default_value.as_size = default_value;
+}
+
+void flagSetBytesField(FlagSet* fs, size_t offset,
+    char* name, char short_name, uint64_t default_value, char* description) {
+  Flag* flag = flagMake(fs, NULL, FLAG_TYPE_BYTES, name, short_name, description);
+
+  flag->offset                  = offset;
+  flag->default_value.as_uint64 = default_value;
+}
+
+// stringDuplicate returns null terminated copy of the first len bytes of src
+// allocated from the arena of the context.
+static char* stringDuplicate(FlagContext* ctx, const char* src, int len) {
+  if (src == NULL) {
+    return NULL;
+  }
+
+  char* result = CAST(char*, arenaAlloc(&ctx->arena, len + 1));
+  memcpy(result, src, len);
+  result[len] = 0;
+
+  return result;
+}
+
+// shiftArgs shifts arguments by one and returns current argument.
+static char* shiftArgs(int* argc, char*** argv) {
+  assert(*argc > 0);
+
+  char* value = **argv;
+  *argv += 1;
+  *argc -= 1;
+
+  return value;
+}
+
+static void setError(FlagContext* ctx, FlagErrorCode code, const char* flag_name) {
+  size_t len = strlen(flag_name);
+  if (len > FLAGS_FLAG_MAX_LEN - 1) {
+    len = FLAGS_FLAG_MAX_LEN - 1;
+  }
+
+  ctx->error_code = code;
+  memcpy(ctx->error_flag_name, flag_name, len);
+  ctx->error_flag_name[len] = '\0';
+}
+
+// setErrorSlice sets error for the flag named by the first len bytes of flag_name.
+static void setErrorSlice(FlagContext* ctx, FlagErrorCode code, const char* flag_name, int len) {
+  if (len > FLAGS_FLAG_MAX_LEN - 1) {
+    len = FLAGS_FLAG_MAX_LEN - 1;
+  }
+
+  ctx->error_code = code;
+  memcpy(ctx->error_flag_name, flag_name, len);
+  ctx->error_flag_name[len] = '\0';
+}
+
+// contextSources makes sure that the context tracks sources of all flags.
+static void contextSources(const FlagSet* fs, FlagContext* ctx) {
+  if (ctx->sources_cap < fs->flags_len) {
+    ctx->sources = CAST(unsigned char*, realloc(ctx->sources, fs->flags_cap));
+    memset(ctx->sources + ctx->sources_cap, FLAG_SOURCE_DEFAULT, fs->flags_cap - ctx->sources_cap);
+    ctx->sources_cap = fs->flags_cap;
+    if (ctx->values == NULL) {
+      ctx->staged = CAST(FlagValue*, realloc(ctx->staged, fs->flags_cap * sizeof(FlagValue)));
+    }
+  }
+}
+
+// flagHasStorage reports whether the context has somewhere to store value of
+// the flag, field flags have it only when parsed with a base.
+static bool flagHasStorage(const FlagContext* ctx, const Flag* flag) {
+  return flag->ptr != NULL || ctx->values != NULL ||
+    (flag->offset != FLAGS_NO_OFFSET && ctx->base != NULL);
+}
+
+// flagDestination returns pointer where value of the flag from the source is
+// stored by the context or NULL if the flag already has value from the source
+// with higher precedence.
+// @note: callers check flagHasStorage first.
+static void* flagDestination(const FlagSet* fs, FlagContext* ctx, const Flag* flag, FlagSource source) {
+  unsigned char* current = ctx->sources + (flag - fs->flags);
+  if (*current > source) {
+    return NULL;
+  }
+  *current = CAST(unsigned char, source);
+
+  if (flag->offset != FLAGS_NO_OFFSET && ctx->base != NULL) {
+    return ctx->base + flag->offset;
+  }
+  if (ctx->values != NULL) {
+    return ctx->values + (flag - fs->flags);
+  }
+  if (flag->atomic) {
+    return ctx->staged + (flag - fs->flags);
+  }
+  assert(flag->ptr != NULL && "field flag requires flagSetParseInto");
+  return flag->ptr;
+}
+
+
+// lookupConfigFlag attempts to find the flag configuration by its name.
+// Returns true if the configuration is found and sets `dst` to pointer to the
+// found configuration; otherwise, returns false.
+static bool lookupConfigFlag(const FlagSet* fs, const Flag** dst, const char* flag, int len) {
+  if (len < 1) {
+    return false;
+  }
+
+  const Flag* item = flagIndexLookup(fs, flag, len);
+  if (item == NULL) {
+    return false;
+  }
+
+  *dst = item;
+  return true;
+}
+
+// lookupShortFlag attempts to find the flag configuration by its short name.
+// Returns true if the configuration is found and sets `dst` to pointer to the
+// found configuration; otherwise, returns false.
+static bool lookupShortFlag(const FlagSet* fs, const Flag** dst, char short_name) {
+  int i = fs->short_index[CAST(unsigned char, short_name)];
+  if (i == 0) {
+    return false;
+  }
+
+  *dst = fs->flags + i - 1;
+  return true;
+}
+
+#ifdef WITH_INI
+
+// isConfigName checks if the long name is the one of the configuration file flag.
+static bool isConfigName(const FlagSet* fs, const char* name, int len);
+
+// parseIniConfig attempts to populate flags from an INI configuration file.
+// Returns true on success. Returns false on error and populates
+// error_code and error_flag_name fields in the FlagContext structure.
+static bool parseIniConfig(const FlagSet* fs, FlagContext* ctx, const char* filename);
+
+#endif
+
+// FlagResponseFile identifies response file that is being expanded, files
+// that are expanded at the same time form a chain through parent.
+typedef struct FlagResponseFile {
+  dev_t dev;
+  ino_t ino;
+  const struct FlagResponseFile* parent;
+} FlagResponseFile;
+
+// parseResponseFile parses arguments read from the response file, arg is the
+// argument that references the file including the '@' prefix.
+static bool parseResponseFile(const FlagSet* fs, FlagContext* ctx,
+    char* arg, const FlagResponseFile* parent);
+
+// digitValue returns value of the hexadecimal digit or 16 if c is not a digit.
+static inline unsigned int digitValue(char c) {
+  unsigned int digit = CAST(unsigned char, c) - '0';
+  if (digit < 10) {
+    return digit;
+  }
+  digit = (CAST(unsigned char, c) | 0x20) - 'a';
+  return digit < 6 ? digit + 10 : 16;
+}
+
+// parseRadix parses unsigned integer in the base with '_' separators between
+// digits. It does not depend on the locale.
+// Returns pointer past the last consumed character or NULL if there are no
+// digits or the value does not fit into uint64_t.
+static const char* parseRadix(const char* str, unsigned int base, uint64_t* dst) {
+  // Largest value that could be multiplied by base and the largest digit
+  // that could be added to it without overflow.
+  uint64_t     cutoff = UINT64_MAX / base;
+  unsigned int cutlim = UINT64_MAX % base;
+
+  uint64_t     result = 0;
+  unsigned int digit  = digitValue(*str);
+  if (digit >= base) {
+    return NULL;
+  }
+
+  do {
+    if (result > cutoff || (result == cutoff && digit > cutlim)) {
+      return NULL;
+    }
+    result = result * base + digit;
+    str++;
+
+    if (*str == '_' && digitValue(str[1]) < base) {
+      str++;
+    }
+  } while ((digit = digitValue(*str)) < base);
+
+  *dst = result;
+  return str;
+}
+
+// parseDigits parses unsigned integer with optional base prefix (0x, 0o, 0b),
+// see parseRadix.
+static const char* parseDigits(const char* str, uint64_t* dst) {
+  unsigned int base = 10;
+  if (str[0] == '0') {
+    switch (str[1]) {
+      case 'x': case 'X': base = 16; str += 2; break;
+      case 'o': case 'O': base = 8;  str += 2; break;
+      case 'b': case 'B': base = 2;  str += 2; break;
+    }
+  }
+
+  return parseRadix(str, base, dst);
+}
+
+// parseInt parses the whole string as signed integer in range [min, max].
+static bool parseInt(const char* str, int64_t min, int64_t max, int64_t* dst) {
+  bool negative = *str == '-';
+  if (*str == '-' || *str == '+') {
+    str++;
+  }
+
+  uint64_t magnitude;
+  str = parseDigits(str, &magnitude);
+  if (str == NULL || *str != '\0') {
+    return false;
+  }
+
+  if (negative) {
+    // @note: -(min + 1) + 1 avoids overflow for INT64_MIN.
+    if (min >= 0 || magnitude > CAST(uint64_t, -(min + 1)) + 1) {
+      return false;
+    }
+    *dst = magnitude == 0 ? 0 : -CAST(int64_t, magnitude - 1) - 1;
+  } else {
+    if (max < 0 || magnitude > CAST(uint64_t, max)) {
+      return false;
+    }
+    *dst = CAST(int64_t, magnitude);
+  }
+
+  return true;
+}
+
+// parseUint parses the whole string as unsigned integer not greater than max.
+static bool parseUint(const char* str, uint64_t max, uint64_t* dst) {
+  if (*str == '+') {
+    str++;
+  }
+
+  uint64_t result;
+  str = parseDigits(str, &result);
+  if (str == NULL || *str != '\0' || result > max) {
+    return false;
+  }
+
+  *dst = result;
+  return true;
+}
+
+// bytesUnit returns multiplier of the unit suffix: B, decimal KB, MB, GB, TB,
+// PB, EB or binary KiB, MiB, GiB, TiB, PiB, EiB. Letters are case insensitive
+// except the "i". Returns 0 if the suffix is not a unit.
+static uint64_t bytesUnit(const char* str) {
+  static const char units[] = "KMGTPE";
+
+  if ((str[0] | 0x20) == 'b' && str[1] == '\0') {
+    return 1;
+  }
+
+  const char* unit = str[0] != '\0' ? strchr(units, str[0] & ~0x20) : NULL;
+  if (unit == NULL) {
+    return 0;
+  }
+
+  uint64_t base = 1000;
+  str++;
+  if (str[0] == 'i') {
+    base = 1024;
+    str++;
+  }
+  if ((str[0] | 0x20) != 'b' || str[1] != '\0') {
+    return 0;
+  }
+
+  uint64_t result = 1;
+  for (const char* p = units; p <= unit; p++) {
+    result *= base;
+  }
+  return result;
+}
+
+// parseBytes parses the whole string as size in bytes, decimal number may be
+// followed by spaces and the unit suffix, see bytesUnit.
+// @note: base prefixes are not accepted, "0B" is zero bytes, not binary.
+static bool parseBytes(const char* str, uint64_t* dst) {
+  if (*str == '+') {
+    str++;
+  }
+
+  uint64_t result;
+  str = parseRadix(str, 10, &result);
+  if (str == NULL) {
+    return false;
+  }
+
+  while (*str == ' ') {
+    str++;
+  }
+
+  uint64_t unit = *str != '\0' ? bytesUnit(str) : 1;
+  if (unit == 0 || result > UINT64_MAX / unit) {
+    return false;
+  }
+
+  *dst = result * unit;
+  return true;
+}
+
+// Maximum number of decimal digits that always fit into uint64_t.
+#define DECIMAL_MAX_DIGITS 19
+
+// Decimal is a floating point number split into its decimal parts.
+typedef struct {
+  // Sign of the number
+  bool negative;
+  // Number is infinity or NaN
+  bool inf;
+  bool nan;
+  // First significant digits of the number
+  uint64_t mantissa;
+  // Decimal exponent, number equals to mantissa * 10^exponent unless truncated
+  int exponent;
+  // More than DECIMAL_MAX_DIGITS significant digits were present
+  bool truncated;
+  // Integer and fraction digits as they appear in the source
+  const char* int_digits;
+  int int_len;
+  const char* frac_digits;
+  int frac_len;
+  // Value of the explicit exponent clamped to the range that fits into int
+  int exp10;
+} Decimal;
+
+// wordEqual compares str with lowercase word ignoring case of str.
+static bool wordEqual(const char* str, const char* word) {
+  for (; *word != '\0'; str++, word++) {
+    if ((*str | 0x20) != *word) return false;
+  }
+  return *str == '\0';
+}
+
+// parseDecimal parses the whole string as decimal floating point number:
+// [+-] digits [. digits] [(e|E) [+-] digits], "inf", "infinity" or "nan".
+// It does not depend on the locale, radix character is always '.'.
+static bool parseDecimal(const char* str, Decimal* dst) {
+  memset(dst, 0, sizeof(Decimal));
+
+  dst->negative = *str == '-';
+  if (*str == '-' || *str == '+') {
+    str++;
+  }
+
+  if (wordEqual(str, "inf") || wordEqual(str, "infinity")) {
+    dst->inf = true;
+    return true;
+  }
+  if (wordEqual(str, "nan")) {
+    dst->nan = true;
+    return true;
+  }
+
+  int digits = 0;
+
+  dst->int_digits = str;
+  for (; *str >= '0' && *str <= '9'; str++) {
+    if (dst->mantissa == 0 && *str == '0') {
+      continue;
+    }
+    if (digits < DECIMAL_MAX_DIGITS) {
+      dst->mantissa = dst->mantissa * 10 + (*str - '0');
+      digits++;
+    } else {
+      dst->truncated |= *str != '0';
+      dst->exponent++;
+    }
+  }
+  dst->int_len = str - dst->int_digits;
+
+  if (*str == '.') {
+    str++;
+    dst->frac_digits = str;
+    for (; *str >= '0' && *str <= '9'; str++) {
+      if (dst->mantissa == 0 && *str == '0') {
+        dst->exponent--;
+        continue;
+      }
+      if (digits < DECIMAL_MAX_DIGITS) {
+        dst->mantissa = dst->mantissa * 10 + (*str - '0');
+        dst->exponent--;
+        digits++;
+      } else {
+        dst->truncated |= *str != '0';
+      }
+    }
+    dst->frac_len = str - dst->frac_digits;
+  }
+
+  if (dst->int_len == 0 && dst->frac_len == 0) {
+    return false;
+  }
+
+  if (*str == 'e' || *str == 'E') {
+    str++;
+
+    bool negative = *str == '-';
+    if (*str == '-' || *str == '+') {
+      str++;
+    }
+    if (*str < '0' || *str > '9') {
+      return false;
+    }
+
+    int exp10 = 0;
+    for (; *str >= '0' && *str <= '9'; str++) {
+      // @note: exponents this large are infinity or zero anyway.
+      if (exp10 < 100000) {
+        exp10 = exp10 * 10 + (*str - '0');
+      }
+    }
+    dst->exp10     = negative ? -exp10 : exp10;
+    dst->exponent += dst->exp10;
+  }
+
+  return *str == '\0';
+}
+
+// decimalFallback converts number with strtod/strtof from the canonical
+// representation without radix character, which does not depend on the locale.
+// C library conversion is correctly rounded.
+static double decimalFallback(const Decimal* number, bool single, float* as_float) {
+  char  stack[64];
+  int   size = number->int_len + number->frac_len + 16;
+  char* buf  = size <= CAST(int, sizeof(stack)) ? stack : CAST(char*, malloc(size));
+
+  int len = 0;
+  buf[len++] = number->negative ? '-' : '+';
+  memcpy(buf + len, number->int_digits, number->int_len);
+  len += number->int_len;
+  if (number->frac_len > 0) {
+    memcpy(buf + len, number->frac_digits, number->frac_len);
+    len += number->frac_len;
+  }
+  snprintf(buf + len, size - len, "e%d", number->exp10 - number->frac_len);
+
+  double result = 0;
+  if (single) {
+    *as_float = strtof(buf, NULL);
+  } else {
+    result = strtod(buf, NULL);
+  }
+
+  if (buf != stack) {
+    free(buf);
+  }
+  return result;
+}
+
+// decimalToDouble returns correctly rounded double value of the number.
+static double decimalToDouble(const Decimal* number) {
+  static const double powers[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+  };
+
+  if (number->nan) {
+    return number->negative ? -NAN : NAN;
+  }
+  if (number->inf) {
+    return number->negative ? -INFINITY : INFINITY;
+  }
+
+#if FLT_EVAL_METHOD == 0
+  // Clinger's fast path: mantissa and power of ten are exact doubles, so a
+  // single multiplication or division is correctly rounded.
+  uint64_t mantissa = number->mantissa;
+  int      exponent = number->exponent;
+  if (!number->truncated && mantissa <= (1ull << 53)) {
+    double result = 0;
+    if (mantissa == 0) {
+      return number->negative ? -0.0 : 0.0;
+    }
+    // Move extra power of ten into the mantissa while it stays exact.
+    while (exponent > 22 && mantissa * 10 <= (1ull << 53)) {
+      mantissa *= 10;
+      exponent--;
+    }
+    if (exponent >= 0 && exponent <= 22) {
+      result = CAST(double, mantissa) * powers[exponent];
+      return number->negative ? -result : result;
+    }
+    if (exponent < 0 && exponent >= -22) {
+      result = CAST(double, mantissa) / powers[-exponent];
+      return number->negative ? -result : result;
+    }
+  }
+#endif
+
+  return decimalFallback(number, false, NULL);
+}
+
+// decimalToFloat returns correctly rounded float value of the number.
+static float decimalToFloat(const Decimal* number) {
+  static const float powers[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+  };
+
+  if (number->nan) {
+    return number->negative ? -NAN : NAN;
+  }
+  if (number->inf) {
+    return number->negative ? -INFINITY : INFINITY;
+  }
+
+#if FLT_EVAL_METHOD == 0
+  uint64_t mantissa = number->mantissa;
+  int      exponent = number->exponent;
+  if (!number->truncated && mantissa <= (1u << 24)) {
+    float result = 0;
+    if (mantissa == 0) {
+      return number->negative ? -0.0f : 0.0f;
+    }
+    if (exponent >= 0 && exponent <= 10) {
+      result = CAST(float, mantissa) * powers[exponent];
+      return number->negative ? -result : result;
+    }
+    if (exponent < 0 && exponent >= -10) {
+      result = CAST(float, mantissa) / powers[-exponent];
+      return number->negative ? -result : result;
+    }
+  }
+#endif
+
+  float result = 0;
+  decimalFallback(number, true, &result);
+  return result;
+}
+
+// parseFixedDigits parses exactly n decimal digits.
+static bool parseFixedDigits(const char* str, int n, int* dst) {
+  int result = 0;
+  for (int i = 0; i < n; i++) {
+    if (str[i] < '0' || str[i] > '9') {
+      return false;
+    }
+    result = result * 10 + (str[i] - '0');
+  }
+  *dst = result;
+  return true;
+}
+
+// daysFromCivil returns number of days since 1970-01-01 for the date in the
+// proleptic Gregorian calendar.
+static int64_t daysFromCivil(int year, int month, int day) {
+  year -= month <= 2;
+  int64_t era = (year >= 0 ? year : year - 399) / 400;
+  int64_t yoe = year - era * 400;
+  int64_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+// localStandardOffset returns offset of the local standard time from UTC.
+static long localStandardOffset(void) {
+  tzset();
+  return -CAST(long, timezone);
+}
+
+// parseTime parses time in the FLAGS_TIME_FMT layout. For the default layout
+// epoch is computed arithmetically, local zone offset is resolved once and
+// cached in tz_offset.
+static bool parseTime(const char* str, long* tz_offset, time_t* dst) {
+  if (strcmp(FLAGS_TIME_FMT, "%Y-%m-%dT%H:%M:%S") != 0) {
+    struct tm result;
+    memset(&result, 0, sizeof(result));
+    if (strptime(str, FLAGS_TIME_FMT, &result) == str) {
+      return false;
+    }
+
+    *dst = mktime(&result);
+    return true;
+  }
+
+  static const int days_in_month[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+  int year, month, day, hour, minute, second;
+  if (!parseFixedDigits(str, 4, &year) || str[4] != '-' ||
+      !parseFixedDigits(str + 5, 2, &month) || str[7] != '-' ||
+      !parseFixedDigits(str + 8, 2, &day) || str[10] != 'T' ||
+      !parseFixedDigits(str + 11, 2, &hour) || str[13] != ':' ||
+      !parseFixedDigits(str + 14, 2, &minute) || str[16] != ':' ||
+      !parseFixedDigits(str + 17, 2, &second)) {
+    return false;
+  }
+
+  bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+  if (month < 1 || month > 12 || day < 1 || day > days_in_month[month - 1] ||
+      (month == 2 && day == 29 && !leap) ||
+      hour > 23 || minute > 59 || second > 60) {
+    return false;
+  }
+
+  const char* suffix = str + 19;
+  long        offset = 0;
+
+  if (suffix[0] == '\0') {
+    if (*tz_offset == FLAGS_TZ_UNRESOLVED) {
+      *tz_offset = localStandardOffset();
+    }
+    offset = *tz_offset;
+  } else if (suffix[0] == 'Z' && suffix[1] == '\0') {
+    offset = 0;
+  } else if (suffix[0] == '+' || suffix[0] == '-') {
+    int hours, minutes = 0;
+    if (!parseFixedDigits(suffix + 1, 2, &hours)) {
+      return false;
+    }
+
+    const char* rest = suffix + 3;
+    if (*rest == ':') {
+      rest++;
+    }
+    if (*rest != '\0') {
+      if (!parseFixedDigits(rest, 2, &minutes) || rest[2] != '\0') {
+        return false;
+      }
+    }
+    if (hours > 23 || minutes > 59) {
+      return false;
+    }
+
+    offset = (hours * 60 + minutes) * 60;
+    if (suffix[0] == '-') {
+      offset = -offset;
+    }
+  } else {
+    return false;
+  }
+
+  int64_t seconds = daysFromCivil(year, month, day) * 86400 +
+    hour * 3600 + minute * 60 + second - offset;
+
+  *dst = CAST(time_t, seconds);
+  return true;
+}
+
+// parseValue converts value to the flag type, see flagParseValue.
+// Local zone offset for the time values is cached in tz_offset.
+static bool parseValue(FlagType type, void* dst, char* value, long* tz_offset) {
+  switch (type) {
+    case FLAG_TYPE_BOOL:
+      {
+        if (strcmp(value, "true") == 0) {
+          *((bool*)dst) = true;
+        } else if (strcmp(value, "false") == 0) {
+          *((bool*)dst) = false;
+        } else {
+          return false;
+        }
+      } break;
+    case FLAG_TYPE_STRING: 
+      {
+        *((char**)dst) = value;
+      } break;
+    case FLAG_TYPE_INT:
+      {
+        int64_t result;
+        if (!parseInt(value, INT_MIN, INT_MAX, &result)) {
+          return false;
+        }
+
+        *((int*)dst) = (int)result;
+      } break;
+    case FLAG_TYPE_FLOAT:
+      {
+        Decimal number;
+        if (!parseDecimal(value, &number)) {
+          return false;
+        }
+
+        *((float*)dst) = decimalToFloat(&number);
+      } break;
+    case FLAG_TYPE_DOUBLE:
+      {
+        Decimal number;
+        if (!parseDecimal(value, &number)) {
+          return false;
+        }
+
+        *((double*)dst) = decimalToDouble(&number);
+      } break;
+    case FLAG_TYPE_TIME:
+      {
+        if (!parseTime(value, tz_offset, (time_t*)dst)) {
+          return false;
+        }
+      } break;
+    case FLAG_TYPE_INT64:
+      {
+        if (!parseInt(value, INT64_MIN, INT64_MAX, (int64_t*)dst)) {
+          return false;
+        }
+      } break;
+    case FLAG_TYPE_UINT64:
+      {
+        if (!parseUint(value, UINT64_MAX, (uint64_t*)dst)) {
+          return false;
+        }
+      } break;
+    case FLAG_TYPE_SIZE:
+      {
+        uint64_t result;
+        if (!parseUint(value, SIZE_MAX, &result)) {
+          return false;
+        }
+
+        *((size_t*)dst) = CAST(size_t, result);
+      } break;
+    case FLAG_TYPE_BYTES:
+      {
+        if (!parseBytes(value, (uint64_t*)dst)) {
+          return false;
+        }
+      } break;
+  }
+
+  return true;
+}
+
+bool flagParseValue(FlagType type, void* dst, char* value) {
+  long tz_offset = FLAGS_TZ_UNRESOLVED;
+  return parseValue(type, dst, value, &tz_offset);
+}
+
+// overrideFlag sets value of the flag with the highest precedence.
+static bool overrideFlag(const FlagSet* fs, FlagContext* ctx, const char* name, char* value) {
+  const Flag* conf = flagIndexLookup(fs, name, strlen(name));
+  if (conf == NULL || !flagHasStorage(ctx, conf)) {
+    return false;
+  }
+
+  // @note: value is validated first, so invalid value neither replaces the
+  // current one nor shadows values of other sources.
+  FlagValue parsed;
+  long      tz_offset = FLAGS_TZ_UNRESOLVED;
+  if (!parseValue(conf->type, &parsed, value, &tz_offset)) {
+    return false;
+  }
+  // @note: overrides are usually formatted into temporary buffers, unlike
+  // argv they do not outlive the parse.
+  if (conf->type == FLAG_TYPE_STRING) {
+    parsed.as_string = stringDuplicate(ctx, value, strlen(value));
+  }
+
+  contextSources(fs, ctx);
+  storeValue(conf->type, flagDestination(fs, ctx, conf, FLAG_SOURCE_OVERRIDE), parsed);
+  return true;
+}
+
+// sourceOf returns source of the flag value in the context.
+static FlagSource sourceOf(const FlagSet* fs, const FlagContext* ctx, const char* name) {
+  const Flag* flag = flagIndexLookup(fs, name, strlen(name));
+  assert(flag != NULL && "unknown flag");
+
+  int i = flag - fs->flags;
+  return i < ctx->sources_cap ? CAST(FlagSource, ctx->sources[i]) : FLAG_SOURCE_DEFAULT;
+}
+
+#define FLAGS_SNAPSHOT_MAGIC   0x53474c46u // "FLGS"
+#define FLAGS_SNAPSHOT_VERSION 2u
+#define FLAGS_SNAPSHOT_NO_STRING UINT32_MAX
+
+// FlagSnapshotSource identifies version of the configuration file the
+// snapshot was compiled from, it is zero for snapshots of flagSetSave.
+typedef struct {
+  uint64_t size;
+  int64_t  mtime_sec;
+  int64_t  mtime_nsec;
+} FlagSnapshotSource;
+
+// FlagSnapshotHeader starts the snapshot, it is followed by flags_len records
+// in the order of registration and by the string pool.
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  // Hash of the names and types of the flags
+  uint64_t schema;
+  uint32_t flags_len;
+  uint32_t pool_len;
+  FlagSnapshotSource source;
+} FlagSnapshotHeader;
+
+// FlagSnapshotRecord contains value of the flag.
+typedef struct {
+  // FlagType
+  uint8_t type;
+  // FlagSource, values of flags with default source are not stored
+  uint8_t source;
+  uint8_t reserved[6];
+  union {
+    int64_t as_int;
+    float   as_float;
+    double  as_double;
+    int64_t as_time_t;
+    uint64_t as_uint;
+    uint8_t as_bool;
+    struct {
+      // Offset of the null terminated string in the pool
+      uint32_t offset;
+      uint32_t len;
+    } as_string;
+  } value;
+} FlagSnapshotRecord;
+
+// schemaHash returns FNV-1a hash of the names and types of the flags.
+static uint64_t schemaHash(const FlagSet* fs) {
+  uint64_t hash = 14695981039346656037ull;
+  for (int i = 0; i < fs->flags_len; i++) {
+    const Flag* flag = fs->flags + i;
+    // @note: name is hashed with its null byte, so names could not merge.
+    for (const char* c = flag->name; ; c++) {
+      hash ^= CAST(unsigned char, *c);
+      hash *= 1099511628211ull;
+      if (*c == '\0') {
+        break;
+      }
+    }
+    hash ^= CAST(uint64_t, flag->type);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// snapshotSource describes the file by its size and modification time, which
+// is compared with nanoseconds, so edits within the same second are noticed.
+static FlagSnapshotSource snapshotSource(const struct stat* st) {
+  FlagSnapshotSource source;
+  source.size      = CAST(uint64_t, st->st_size);
+  source.mtime_sec = CAST(int64_t, st->st_mtime);
+#if defined(__APPLE__)
+  source.mtime_nsec = st->st_mtimespec.tv_nsec;
+#elif defined(st_mtime)
+  // @note: st_mtime is a macro when struct stat holds struct timespec.
+  source.mtime_nsec = st->st_mtim.tv_nsec;
+#elif defined(__GLIBC__)
+  source.mtime_nsec = st->st_mtimensec;
+#else
+  source.mtime_nsec = 0;
+#endif
+  return source;
+}
+
+// flagValue returns pointer to the value of the flag in the context or NULL
+// if the flag has no storage.
+static const void* flagValue(const FlagSet* fs, const FlagContext* ctx, const Flag* flag) {
+  if (ctx->values != NULL) {
+    return ctx->values + (flag - fs->flags);
+  }
+  if (flag->atomic) {
+    return ctx->staged + (flag - fs->flags);
+  }
+  return flag->ptr;
+}
+
+// writeSnapshot writes values of the context into the snapshot, source is
+// the configuration file the values were parsed from or NULL.
+static bool writeSnapshot(const FlagSet* fs, const FlagContext* ctx,
+    const char* filename, const struct stat* source) {
+  FlagSnapshotRecord* records = CAST(FlagSnapshotRecord*,
+      calloc(fs->flags_len > 0 ? fs->flags_len : 1, sizeof(FlagSnapshotRecord)));
+  char*    pool     = NULL;
+  uint32_t pool_len = 0;
+  uint32_t pool_cap = 0;
+
+  for (int i = 0; i < fs->flags_len; i++) {
+    const Flag*         flag   = fs->flags + i;
+    const void*         src    = flagValue(fs, ctx, flag);
+    FlagSnapshotRecord* record = records + i;
+
+    record->type   = CAST(uint8_t, flag->type);
+    record->source = i < ctx->sources_cap ? ctx->sources[i] : CAST(uint8_t, FLAG_SOURCE_DEFAULT);
+    if (record->source == FLAG_SOURCE_DEFAULT || src == NULL) {
+      record->source = FLAG_SOURCE_DEFAULT;
+      continue;
+    }
+
+    switch (flag->type) {
+      case FLAG_TYPE_BOOL:
+        record->value.as_bool = *((const bool*)src) ? 1 : 0;
+        break;
+      case FLAG_TYPE_STRING:
+        {
+          const char* str = *((char* const*)src);
+          if (str == NULL) {
+            record->value.as_string.offset = FLAGS_SNAPSHOT_NO_STRING;
+            break;
+          }
+
+          uint32_t len = strlen(str);
+          while (pool_len + len + 1 > pool_cap) {
+            pool_cap = pool_cap > 0 ? pool_cap * 2 : FLAGS_ARENA_BLOCK_SIZE;
+            pool     = CAST(char*, realloc(pool, pool_cap));
+          }
+          memcpy(pool + pool_len, str, len + 1);
+
+          record->value.as_string.offset = pool_len;
+          record->value.as_string.len    = len;
+          pool_len += len + 1;
+        } break;
+      case FLAG_TYPE_INT:
+        record->value.as_int = *((const int*)src);
+        break;
+      case FLAG_TYPE_FLOAT:
+        record->value.as_float = *((const float*)src);
+        break;
+      case FLAG_TYPE_DOUBLE:
+        record->value.as_double = *((const double*)src);
+        break;
+      case FLAG_TYPE_TIME:
+        record->value.as_time_t = *((const time_t*)src);
+        break;
+      case FLAG_TYPE_INT64:
+        record->value.as_int = *((const int64_t*)src);
+        break;
+      case FLAG_TYPE_UINT64:
+      case FLAG_TYPE_BYTES:
+        record->value.as_uint = *((const uint64_t*)src);
+        break;
+      case FLAG_TYPE_SIZE:
+        record->value.as_uint = *((const size_t*)src);
+        break;
+    }
+  }
+
+  FlagSnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic     = FLAGS_SNAPSHOT_MAGIC;
+  header.version   = FLAGS_SNAPSHOT_VERSION;
+  header.schema    = schemaHash(fs);
+  header.flags_len = fs->flags_len;
+  header.pool_len  = pool_len;
+  if (source != NULL) {
+    header.source = snapshotSource(source);
+  }
+
+  bool  ok     = false;
+  FILE* stream = fopen(filename, "wb");
+  if (stream != NULL) {
+    ok = fwrite(&header, sizeof(header), 1, stream) == 1 &&
+      fwrite(records, sizeof(FlagSnapshotRecord), fs->flags_len, stream) == CAST(size_t, fs->flags_len) &&
+      (pool_len == 0 || fwrite(pool, 1, pool_len, stream) == pool_len);
+    ok = fclose(stream) == 0 && ok;
+  }
+
+  free(records);
+  free(pool);
+  return ok;
+}
+
+// loadSnapshot maps the snapshot and stores its values into the context.
+// Returns false without changing the context if the snapshot could not be
+// read, does not match the flag set or, if source is not NULL, was not
+// compiled from this version of the configuration file.
+static bool loadSnapshot(const FlagSet* fs, FlagContext* ctx,
+    const char* filename, const struct stat* source) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+      CAST(size_t, st.st_size) < sizeof(FlagSnapshotHeader)) {
+    close(fd);
+    return false;
+  }
+
+  size_t len     = st.st_size;
+  void*  mapping = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  char*                     data    = CAST(char*, mapping);
+  const FlagSnapshotHeader* header  = (const FlagSnapshotHeader*)data;
+  FlagSnapshotRecord*       records = (FlagSnapshotRecord*)(data + sizeof(FlagSnapshotHeader));
+  size_t records_size = CAST(size_t, fs->flags_len) * sizeof(FlagSnapshotRecord);
+
+  if (header->magic != FLAGS_SNAPSHOT_MAGIC || header->version != FLAGS_SNAPSHOT_VERSION ||
+      header->flags_len != CAST(uint32_t, fs->flags_len) || header->schema != schemaHash(fs) ||
+      len != sizeof(FlagSnapshotHeader) + records_size + header->pool_len) {
+    munmap(mapping, len);
+    return false;
+  }
+
+  if (source != NULL) {
+    FlagSnapshotSource current = snapshotSource(source);
+    if (header->source.size != current.size || header->source.mtime_sec != current.mtime_sec ||
+        header->source.mtime_nsec != current.mtime_nsec) {
+      munmap(mapping, len);
+      return false;
+    }
+  }
+
+  char*    pool     = data + sizeof(FlagSnapshotHeader) + records_size;
+  uint32_t pool_len = header->pool_len;
+
+  // @note: strings are validated before any value is stored, so a damaged
+  // snapshot leaves the context untouched.
+  for (int i = 0; i < fs->flags_len; i++) {
+    const FlagSnapshotRecord* record = records + i;
+    if (record->type == FLAG_TYPE_STRING && record->source != FLAG_SOURCE_DEFAULT &&
+        record->value.as_string.offset != FLAGS_SNAPSHOT_NO_STRING &&
+        (record->value.as_string.offset >= pool_len ||
+         record->value.as_string.len >= pool_len - record->value.as_string.offset ||
+         pool[record->value.as_string.offset + record->value.as_string.len] != '\0')) {
+      munmap(mapping, len);
+      return false;
+    }
+  }
+
+  retainMapping(ctx, data, len);
+  contextSources(fs, ctx);
+
+  for (int i = 0; i < fs->flags_len; i++) {
+    const Flag*               flag   = fs->flags + i;
+    const FlagSnapshotRecord* record = records + i;
+    if (record->source == FLAG_SOURCE_DEFAULT || !flagHasStorage(ctx, flag)) {
+      continue;
+    }
+
+    void* dst = flagDestination(fs, ctx, flag, CAST(FlagSource, record->source));
+    if (dst == NULL) {
+      continue;
+    }
+
+    switch (flag->type) {
+      case FLAG_TYPE_BOOL:
+        *((bool*)dst) = record->value.as_bool != 0;
+        break;
+      case FLAG_TYPE_STRING:
+        *((char**)dst) = record->value.as_string.offset == FLAGS_SNAPSHOT_NO_STRING ?
+          NULL : pool + record->value.as_string.offset;
+        break;
+      case FLAG_TYPE_INT:
+        *((int*)dst) = CAST(int, record->value.as_int);
+        break;
+      case FLAG_TYPE_FLOAT:
+        *((float*)dst) = record->value.as_float;
+        break;
+      case FLAG_TYPE_DOUBLE:
+        *((double*)dst) = record->value.as_double;
+        break;
+      case FLAG_TYPE_TIME:
+        *((time_t*)dst) = CAST(time_t, record->value.as_time_t);
+        break;
+      case FLAG_TYPE_INT64:
+        *((int64_t*)dst) = record->value.as_int;
+        break;
+      case FLAG_TYPE_UINT64:
+      case FLAG_TYPE_BYTES:
+        *((uint64_t*)dst) = record->value.as_uint;
+        break;
+      case FLAG_TYPE_SIZE:
+        *((size_t*)dst) = CAST(size_t, record->value.as_uint);
+        break;
+    }
+  }
+
+  return true;
+}
+
+bool flagSetSave(const FlagSet* fs, const char* filename) {
+  return writeSnapshot(fs, &fs->ctx, filename, NULL);
+}
+
+bool flagSetLoad(FlagSet* fs, const char* filename) {
+  bool ok = loadSnapshot(fs, &fs->ctx, filename, NULL);
+  if (ok) {
+    publishAtomics(fs, &fs->ctx);
+  }
+  return ok;
+}
+
+bool flagSetOverride(FlagSet* fs, const char* name, char* value) {
+  if (!overrideFlag(fs, &fs->ctx, name, value)) {
+    return false;
+  }
+
+  // @note: other flags may be reset for the parse that is not over yet, so
+  // only the overridden one is published.
+  publishAtomic(fs, &fs->ctx, flagIndexLookup(fs, name, strlen(name)));
+  return true;
+}
+
+bool flagContextOverride(FlagContext* ctx, const char* name, char* value) {
+  return overrideFlag(ctx->fs, ctx, name, value);
+}
+
+FlagSource flagSetSource(const FlagSet* fs, const char* name) {
+  return sourceOf(fs, &fs->ctx, name);
+}
+
+FlagSource flagContextSource(const FlagContext* ctx, const char* name) {
+  return sourceOf(ctx->fs, ctx, name);
+}
+
+#ifndef FLAGS_NO_ATOMICS
+FlagView* flagContextFreeze(FlagContext* ctx) {
+  // @note: the embedded context of the flag set stores values elsewhere.
+  assert(ctx->values != NULL && "context must be created by flagContextNew");
+
+  FlagView* view = CAST(FlagView*, malloc(sizeof(FlagView)));
+  view->ctx  = ctx;
+  FLAGS_ATOMIC_STORE(&view->refs, 1, relaxed);
+  return view;
+}
+
+// pointerLoad returns value of the flag bound to a plain variable.
+static FlagValue pointerLoad(const Flag* flag) {
+  FlagValue value;
+  memset(&value, 0, sizeof(value));
+  switch (flag->type) {
+    case FLAG_TYPE_BOOL:
+      value.as_bool = *CAST(bool*, flag->ptr);
+      break;
+    case FLAG_TYPE_STRING:
+      value.as_string = *CAST(char**, flag->ptr);
+      break;
+    case FLAG_TYPE_INT:
+      value.as_int = *CAST(int*, flag->ptr);
+      break;
+    case FLAG_TYPE_FLOAT:
+      value.as_float = *CAST(float*, flag->ptr);
+      break;
+    case FLAG_TYPE_DOUBLE:
+      value.as_double = *CAST(double*, flag->ptr);
+      break;
+    case FLAG_TYPE_TIME:
+      value.as_time_t = *CAST(time_t*, flag->ptr);
+      break;
+    case FLAG_TYPE_INT64:
+      value.as_int64 = *CAST(int64_t*, flag->ptr);
+      break;
+    case FLAG_TYPE_UINT64:
+    case FLAG_TYPE_BYTES:
+      value.as_uint64 = *CAST(uint64_t*, flag->ptr);
+      break;
+    case FLAG_TYPE_SIZE:
+      value.as_size = *CAST(size_t*, flag->ptr);
+      break;
+  }
+  return value;
+}
+
+FlagView* flagSetView(const FlagSet* fs) {
+  FlagContext* ctx = flagContextNew(fs);
+  contextSources(fs, ctx);
+
+  const FlagContext* src = &fs->ctx;
+  for (int i = 0; i < fs->flags_len; i++) {
+    const Flag* flag = fs->flags + i;
+    if (flag->ptr == NULL) {
+      continue;
+    }
+
+    ctx->sources[i] = i < src->sources_cap ? src->sources[i] : CAST(unsigned char, FLAG_SOURCE_DEFAULT);
+    ctx->values[i] = flag->atomic ? atomicLoad(flag) : pointerLoad(flag);
+    if (flag->type == FLAG_TYPE_STRING && ctx->values[i].as_string != NULL &&
+        ctx->sources[i] != FLAG_SOURCE_DEFAULT) {
+      char* str = ctx->values[i].as_string;
+      ctx->values[i].as_string = stringDuplicate(ctx, str, strlen(str));
+    }
+  }
+
+  return flagContextFreeze(ctx);
 }
 
-static char* stringDuplicate(const char* src, int maxlen) {
-  if (src == NULL) {
-    return NULL;
+const FlagContext* flagViewContext(const FlagView* view) {
+  return view->ctx;
+}
+
+FlagView* flagViewRetain(FlagView* view) {
+  FLAGS_ATOMIC_ADD(&view->refs, 1, relaxed);
+  return view;
+}
+
+void flagViewRelease(FlagView* view) {
+  if (FLAGS_ATOMIC_SUB(&view->refs, 1, acq_rel) == 1) {
+    flagContextFree(view->ctx);
+    free(view);
   }
+}
 
-  int len = strlen(src);
-  len     = (len < maxlen) ? len : maxlen;
+// @note: readers pin the slot only while they take the reference, so the
+// publisher waits for a few instructions at most and readers never wait.
+// Pin and the check of the current slot are sequentially consistent, so
+// either the reader sees the new slot or the publisher sees the pin.
+
+// slotsDrain waits until readers unpin the slot.
+static void slotsDrain(FlagViewSlots* slots, int slot) {
+  while (FLAGS_ATOMIC_LOAD(&slots->pins[slot], seq_cst) != 0) {
+    // @note: the reader holding the pin may be preempted, so the CPU is
+    // given away instead of spinning through its time slice.
+    sched_yield();
+  }
+}
 
-  char* result = CAST(char*, malloc(len));
-  memcpy(result, src, len);
-  result[len] = 0;
+// slotsPublish makes the view current and releases the previous one.
+static void slotsPublish(FlagViewSlots* slots, FlagView* view) {
+  int current = FLAGS_ATOMIC_LOAD(&slots->current, relaxed);
+  int next    = current ^ 1;
+
+  // Readers that raced with the previous publish may still pin the slot.
+  slotsDrain(slots, next);
+  FLAGS_ATOMIC_STORE(&slots->views[next], view, release);
+  FLAGS_ATOMIC_STORE(&slots->current, next, seq_cst);
+
+  slotsDrain(slots, current);
+  FlagView* previous = FLAGS_ATOMIC_LOAD(&slots->views[current], relaxed);
+  FLAGS_ATOMIC_STORE(&slots->views[current], CAST(FlagView*, NULL), relaxed);
+  if (previous != NULL) {
+    flagViewRelease(previous);
+  }
+}
 
-  return result;
+// slotsAcquire returns reference to the current view or NULL.
+static FlagView* slotsAcquire(FlagViewSlots* slots) {
+  for (;;) {
+    int current = FLAGS_ATOMIC_LOAD(&slots->current, acquire);
+    FLAGS_ATOMIC_ADD(&slots->pins[current], 1, seq_cst);
+
+    if (FLAGS_ATOMIC_LOAD(&slots->current, seq_cst) == current) {
+      FlagView* view = FLAGS_ATOMIC_LOAD(&slots->views[current], acquire);
+      if (view != NULL) {
+        flagViewRetain(view);
+      }
+      FLAGS_ATOMIC_SUB(&slots->pins[current], 1, release);
+      return view;
+    }
+
+    FLAGS_ATOMIC_SUB(&slots->pins[current], 1, release);
+  }
 }
 
-// shiftArgs shifts arguments by one and returns current argument.
-static char* shiftArgs(int* argc, char*** argv) {
-  assert(*argc > 0);
+// slotsRelease releases published views, readers keep their references.
+static void slotsRelease(FlagViewSlots* slots) {
+  for (int i = 0; i < 2; i++) {
+    FlagView* view = FLAGS_ATOMIC_LOAD(&slots->views[i], relaxed);
+    if (view != NULL) {
+      flagViewRelease(view);
+      FLAGS_ATOMIC_STORE(&slots->views[i], CAST(FlagView*, NULL), relaxed);
+    }
+  }
+}
 
-  char* value = **argv;
-  *argv += 1;
-  *argc -= 1;
+void flagSetPublish(FlagSet* fs, FlagView* view) {
+  slotsPublish(&fs->published, view);
+}
 
-  return value;
+FlagView* flagSetAcquire(FlagSet* fs) {
+  return slotsAcquire(&fs->published);
 }
+#endif
+
+const char* flagSourceName(FlagSource source) {
+  switch (source) {
+    case FLAG_SOURCE_DEFAULT:
+      return "default";
+    case FLAG_SOURCE_CONFIG:
+      return "config";
+    case FLAG_SOURCE_ENV:
+      return "env";
+    case FLAG_SOURCE_ARGS:
+      return "args";
+    case FLAG_SOURCE_OVERRIDE:
+      return "override";
+  }
 
-static void setError(FlagSet* fs, FlagErrorCode code, char* flag_name) {
-  fs->error_code = code;
-  strncpy(fs->error_flag_name, flag_name, FLAGS_FLAG_MAX_LEN);
+  return "unknown";
 }
 
+// takeValue points value to the value of the flag, either attached to the
+// argument or the next argument. Returns false if there is no value.
+static bool takeValue(char** value, int* argc, char*** argv) {
+  if (*value != NULL) {
+    return true;
+  }
 
-// lookupConfigFlag attempts to find the flag configuration by its name.
-// Returns true if the configuration is found and sets `dst` to pointer to the
-// found configuration; otherwise, returns false.
-static bool lookupConfigFlag(FlagSet* fs, Flag** dst, char* flag) {
-  int len = strlen(flag);
-  if (len < 1) {
+  if (*argc == 0) {
     return false;
   }
 
-  Flag* item;
-  for (int i = 0; i < fs->flags_len; i++) {
-    item = fs->flags + i;
-    if (strncmp(item->name, flag, len) == 0) {
-      *dst = item;
-      return true;
+  *value = shiftArgs(argc, argv);
+  return true;
+}
+
+// applyFlag stores value of the flag into the context, value is NULL if it
+// was not attached to the flag. Bool flags take only attached values.
+static bool applyFlag(const FlagSet* fs, FlagContext* ctx, const Flag* conf,
+    char* value, int* argc, char*** argv) {
+  if (!flagHasStorage(ctx, conf)) {
+    setError(ctx, FLAG_ERROR_CODE_FIELD_WITHOUT_TARGET, conf->name);
+    return false;
+  }
+
+  // Destination is NULL only if the program overrides the flag.
+  void* dst = flagDestination(fs, ctx, conf, FLAG_SOURCE_ARGS);
+  if (conf->type == FLAG_TYPE_BOOL && value == NULL) {
+    if (dst != NULL) {
+      *((bool*)dst) = true;
     }
+    return true;
   }
 
-  return false;
+  if (!takeValue(&value, argc, argv)) {
+    setError(ctx, FLAG_ERROR_CODE_MISSING_VALUE, conf->name);
+    return false;
+  }
+
+  if (dst != NULL && !parseValue(conf->type, dst, value, &ctx->tz_offset)) {
+    setError(ctx, FLAG_ERROR_CODE_INVALID_VALUE, conf->name);
+    return false;
+  }
+
+  return true;
 }
 
-// lookupFlag attempts to find the flag configuration by its name.
-// Returns true if the configuration is found and sets `dst` to pointer to the
-// found configuration; otherwise, returns false.
-static bool lookupFlag(FlagSet* fs, Flag** dst, char* flag) {
-  int len = strlen(flag);
-  if (len < 2 || flag[0] != '-') {
+#ifdef WITH_INI
+// applyConfig parses configuration file named by the value, name is the flag
+// as written in the argument and is used for errors.
+static bool applyConfig(const FlagSet* fs, FlagContext* ctx,
+    const char* name, int len, char* value, int* argc, char*** argv) {
+  if (!takeValue(&value, argc, argv)) {
+    setErrorSlice(ctx, FLAG_ERROR_CODE_MISSING_VALUE, name, len);
     return false;
   }
 
-  Flag* item;
-  if (flag[1] == '-') {
-    // Long name is used
-    char* name = flag + 2;
-    for (int i = 0; i < fs->flags_len; i++) {
-      item = fs->flags + i;
-      if (strncmp(item->name, name, len - 2) == 0) {
-        *dst = item;
-        return true;
-      }
+  // @note: files are loaded after the command line, so values that are set
+  // by it are not parsed from the file at all.
+  if (ctx->config_files_len == ctx->config_files_cap) {
+    ctx->config_files_cap = ctx->config_files_cap > 0 ? ctx->config_files_cap * 2 : 4;
+    ctx->config_files     = CAST(char**,
+        realloc(ctx->config_files, ctx->config_files_cap * sizeof(char*)));
+  }
+  ctx->config_files[ctx->config_files_len++] = value;
+
+  (void)fs;
+  return true;
+}
+#endif
+
+// parseLongFlag parses --name and --name=value arguments.
+static bool parseLongFlag(const FlagSet* fs, FlagContext* ctx,
+    char* arg, int* argc, char*** argv) {
+  const char* name = arg + 2;
+
+  // @note: name is hashed while searching for the end of it, so the
+  // argument is read only once.
+  unsigned int hash = 2166136261u;
+  int          len  = 0;
+  while (name[len] != '\0' && name[len] != '=') {
+    hash ^= CAST(unsigned char, name[len++]);
+    hash *= 16777619u;
+  }
+
+  char* value = name[len] == '=' ? arg + 2 + len + 1 : NULL;
+
+#ifdef WITH_INI
+  if (isConfigName(fs, name, len)) {
+    return applyConfig(fs, ctx, arg, len + 2, value, argc, argv);
+  }
+#endif
+
+  const Flag* conf = len > 0 ? flagIndexFind(fs, name, len, hash) : NULL;
+  if (conf != NULL) {
+    return applyFlag(fs, ctx, conf, value, argc, argv);
+  }
+
+  if (fs->ignore_unknown) {
+    return true;
+  }
+
+  bool help = len == 4 && memcmp(name, "help", 4) == 0;
+  setErrorSlice(ctx, help ? FLAG_ERROR_CODE_HELP : FLAG_ERROR_CODE_UNKNOWN, arg, len + 2);
+  return false;
+}
+
+// parseShortFlags parses -a, clustered boolean flags -abc and short flags
+// with attached value -p8080.
+static bool parseShortFlags(const FlagSet* fs, FlagContext* ctx,
+    char* arg, int* argc, char*** argv) {
+  for (char* c = arg + 1; *c != '\0'; c++) {
+    char name[3] = { '-', *c, '\0' };
+    // Rest of the argument after the flag is its value.
+    char* value = c[1] != '\0' ? c + 1 : NULL;
+
+#ifdef WITH_INI
+    if (fs->config_flag_short_name != '\0' && *c == fs->config_flag_short_name) {
+      return applyConfig(fs, ctx, name, 2, value, argc, argv);
     }
-  } else if (len == 2) {
-    // Short name is used
-    char name = flag[1];
-    for (int i = 0; i < fs->flags_len; i++) {
-      item = fs->flags + i;
-      if (name == item->short_name) {
-        *dst = item;
+#endif
+
+    const Flag* conf;
+    if (!lookupShortFlag(fs, &conf, *c)) {
+      // @note: the rest of the unknown cluster could be a value, so it is
+      // skipped as a whole.
+      if (fs->ignore_unknown) {
         return true;
       }
+
+      setError(ctx, *c == 'h' ? FLAG_ERROR_CODE_HELP : FLAG_ERROR_CODE_UNKNOWN, name);
+      return false;
+    }
+
+    if (conf->type != FLAG_TYPE_BOOL) {
+      return applyFlag(fs, ctx, conf, value, argc, argv);
+    }
+
+    if (!applyFlag(fs, ctx, conf, NULL, argc, argv)) {
+      return false;
     }
   }
 
-  return false;
+  return true;
 }
 
-static bool isHelpFlag(char* flag) {
-  int len = strlen(flag);
-  if (len < 2 || flag[0] != '-') {
-    return false;
+// addArg adds positional argument, in_argv tells that arg is read from the
+// command line rather than from a response file.
+static void addArg(FlagContext* ctx, char* arg, bool in_argv) {
+  bool in_place = ctx->args != ctx->args_buf;
+  // @note: positional arguments of the command line never outnumber the
+  // arguments that were read, so they are stored over the consumed ones.
+  if (in_place && in_argv) {
+    ctx->args[ctx->args_len++] = arg;
+    return;
   }
 
-  if (flag[1] == '-') {
-    return strcmp("help", flag + 2) == 0;
-  } else if (len == 2) {
-    return flag[1] == 'h';
+  if (ctx->args_len >= ctx->args_cap) {
+    while (ctx->args_len >= ctx->args_cap) {
+      ctx->args_cap = ctx->args_cap > 0 ? ctx->args_cap * 2 : 16;
+    }
+    ctx->args_buf = CAST(char**, realloc(ctx->args_buf, ctx->args_cap * sizeof(char*)));
   }
 
-  return false;
-}
+  if (in_place) {
+    memcpy(ctx->args_buf, ctx->args, ctx->args_len * sizeof(char*));
+  }
 
-#ifdef WITH_INI
+  ctx->args = ctx->args_buf;
+  ctx->args[ctx->args_len++] = arg;
+}
 
-// isConfigFlag checks if the flag is the one that specifies a configuration file.
-static bool isConfigFlag(FlagSet* fs, char* flag);  
+// parseCommand selects subcommand and parses the rest of the arguments with
+// its flag set, argv starts with the name of the subcommand.
+static bool parseCommand(FlagContext* ctx, FlagCommand* command, int argc, char** argv) {
+  if (command->fs == NULL) {
+    command->fs = flagSetNew();
+    command->init(command->fs, command->data);
+  }
 
-// parseIniConfig attempts to populate flags from an INI configuration file.
-// Returns true on success. Returns false on error and populates
-// error_code and error_flag_name fields in the FlagSet structure.
-static bool parseIniConfig(FlagSet* fs, const char* filename);
+  ctx->owner->command = command;
 
-#endif
+  if (!flagSetParse(command->fs, argc, argv)) {
+    const FlagContext* sub = &command->fs->ctx;
+    setError(ctx, sub->error_code, sub->error_flag_name);
+    return false;
+  }
 
-bool flagSetParse(FlagSet* fs, int argc, char** argv) {
-  shiftArgs(&argc, &argv);
+  return true;
+}
 
+// parseArgList parses list of arguments against the flag set and stores
+// values and errors into the context. Arguments are split in place, flag
+// names and values are views into the arguments.
+static bool parseArgList(const FlagSet* fs, FlagContext* ctx,
+    int argc, char** argv, const FlagResponseFile* parent) {
   while (argc > 0) {
-    Flag* conf;
-    char* flag = shiftArgs(&argc, &argv);
-#ifdef WITH_INI
-    if (isConfigFlag(fs, flag)) {
-      if (argc == 0) {
-        setError(fs, FLAG_ERROR_CODE_MISSING_VALUE, flag);
-        return false;
-      }
+    char* arg = shiftArgs(&argc, &argv);
+    if (ctx->terminated) {
+      addArg(ctx, arg, parent == NULL);
+      continue;
+    }
 
-      char* filename = shiftArgs(&argc, &argv);
-      if (!parseIniConfig(fs, filename)) {
+    if (arg[0] == '@' && arg[1] != '\0') {
+      if (!parseResponseFile(fs, ctx, arg, parent)) {
         return false;
       }
 
       continue;
     }
+
+    bool ok = true;
+    if (arg[0] != '-' || arg[1] == '\0') {
+      if (ctx->owner != NULL && ctx->args_len == 0 && parent == NULL && fs->commands_len > 0) {
+        FlagCommand* command = commandLookup(fs, arg);
+        if (command != NULL) {
+          // Subcommand name becomes the program name of its flag set.
+          return parseCommand(ctx, command, argc + 1, argv - 1);
+        }
+      }
+
+      addArg(ctx, arg, parent == NULL);
+    } else if (arg[1] != '-') {
+      ok = parseShortFlags(fs, ctx, arg, &argc, &argv);
+    } else if (arg[2] != '\0') {
+      ok = parseLongFlag(fs, ctx, arg, &argc, &argv);
+    } else {
+      // "--" terminates flags
+      ctx->terminated = true;
+    }
+
+    if (!ok) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+#ifdef __cplusplus
+extern "C" char** environ;
+#else
+extern char** environ;
 #endif
 
-    if (!lookupFlag(fs, &conf, flag)) {
-      if (fs->ignore_unknown) {
-        continue;
+// parseEnv populates flags from the environment variables with the prefix of
+// the flag set. Environment is walked once, names of variables are turned into
+// flag names and found through the long name index. Sets config to the
+// configuration file named by the environment, if any.
+static bool parseEnv(const FlagSet* fs, FlagContext* ctx, char** config) {
+  int plen = strlen(fs->env_prefix);
+
+  for (char** env = environ; *env != NULL; env++) {
+    char* var = *env;
+    if (strncmp(var, fs->env_prefix, plen) != 0 || var[plen] != '_') {
+      continue;
+    }
+
+    // Flag name is lower case with dashes, but underscores are kept as the
+    // fallback for flags that use them.
+    char  name[FLAGS_FLAG_MAX_LEN];
+    char* key = var + plen + 1;
+    int   len = 0;
+    bool  has_underscore = false;
+    while (key[len] != '=' && key[len] != '\0' && len < FLAGS_FLAG_MAX_LEN) {
+      char c = key[len];
+      if (c >= 'A' && c <= 'Z') {
+        c = c - 'A' + 'a';
+      } else if (c == '_') {
+        c = '-';
+        has_underscore = true;
       }
+      name[len++] = c;
+    }
 
-      if (isHelpFlag(flag)) {
-        setError(fs, FLAG_ERROR_CODE_HELP, flag);
-        return false;
+    if (key[len] != '=' || len == 0) {
+      continue;
+    }
+    char* value = key + len + 1;
+
+#ifdef WITH_INI
+    if (isConfigName(fs, name, len)) {
+      *config = value;
+      continue;
+    }
+#else
+    (void)config;
+#endif
+
+    const Flag* conf = flagIndexLookup(fs, name, len);
+    if (conf == NULL && has_underscore) {
+      for (int i = 0; i < len; i++) {
+        if (name[i] == '-') {
+          name[i] = '_';
+        }
       }
+      conf = flagIndexLookup(fs, name, len);
+    }
+
+    if (conf == NULL) {
+      // @note: unrelated variables could share the prefix.
+      continue;
+    }
 
-      setError(fs, FLAG_ERROR_CODE_UNKNOWN, flag);
+    if (!flagHasStorage(ctx, conf)) {
+      setError(ctx, FLAG_ERROR_CODE_FIELD_WITHOUT_TARGET, conf->name);
       return false;
     }
 
-    switch (conf->type) {
-      case FLAG_TYPE_BOOL:
-        {
-          *((bool*)conf->ptr) = true;
-        } break;
-      case FLAG_TYPE_STRING: 
-        {
-          if (argc == 0) {
-            setError(fs, FLAG_ERROR_CODE_MISSING_VALUE, conf->name);
-            return false;
-          }
-          char* value = shiftArgs(&argc, &argv);
-          *((char**)conf->ptr) = value;
-        } break;
-      case FLAG_TYPE_INT:
-        {
-          if (argc == 0) {
-            setError(fs, FLAG_ERROR_CODE_MISSING_VALUE, conf->name);
-            return false;
+    void* dst = flagDestination(fs, ctx, conf, FLAG_SOURCE_ENV);
+    if (dst != NULL && !parseValue(conf->type, dst, value, &ctx->tz_offset)) {
+      setErrorSlice(ctx, FLAG_ERROR_CODE_INVALID_VALUE, var, plen + 1 + len);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// parseArgs parses command line arguments against the flag set and stores
+// values and errors into the context.
+static bool parseArgs(const FlagSet* fs, FlagContext* ctx, int argc, char** argv) {
+  shiftArgs(&argc, &argv);
+
+  ctx->tz_offset  = FLAGS_TZ_UNRESOLVED;
+  ctx->terminated = false;
+  ctx->args       = argv;
+  ctx->args_len   = 0;
+
+  // Overrides of the program outlive parses, other sources start over.
+  contextSources(fs, ctx);
+  for (int i = 0; i < fs->flags_len; i++) {
+    if (ctx->sources[i] != FLAG_SOURCE_OVERRIDE) {
+      ctx->sources[i] = FLAG_SOURCE_DEFAULT;
+    }
+  }
+
+#ifdef WITH_INI
+  ctx->config_files_len = 0;
+#endif
+
+  // @note: sources are resolved from the highest precedence to the lowest,
+  // so values that are shadowed by a higher source are never parsed.
+  if (!parseArgList(fs, ctx, argc, argv, NULL)) {
+    return false;
+  }
+
+  char* config = NULL;
+  if (fs->env_prefix != NULL && !parseEnv(fs, ctx, &config)) {
+    return false;
+  }
+
+#ifdef WITH_INI
+  if (config != NULL && !parseIniConfig(fs, ctx, config)) {
+    return false;
+  }
+
+  // Files on the command line are loaded in order, so the last one wins.
+  for (int i = 0; i < ctx->config_files_len; i++) {
+    if (!parseIniConfig(fs, ctx, ctx->config_files[i])) {
+      return false;
+    }
+  }
+#else
+  (void)config;
+#endif
+
+  return true;
+}
+
+// isArgSpace checks if c separates arguments in the response file.
+static bool isArgSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+    c == '\v' || c == '\f' || c == '\0';
+}
+
+// tokenizeArgs splits data into arguments in place. Unquoted and unescaped
+// arguments are packed one after another at the start of data, each followed
+// by the null byte, except the last one when it ends exactly at the end of
+// data. Returns number of arguments and sets end to the end of packed data.
+static int tokenizeArgs(char* data, size_t len, size_t* end) {
+  size_t r     = 0;
+  size_t w     = 0;
+  int    count = 0;
+
+  for (;;) {
+    while (r < len && isArgSpace(data[r])) {
+      r++;
+    }
+
+    if (r == len) {
+      break;
+    }
+
+    if (data[r] == '#') {
+      while (r < len && data[r] != '\n') {
+        r++;
+      }
+      continue;
+    }
+
+    // @note: writes never overtake reads, quotes and escapes only shrink
+    // the argument.
+    while (r < len && !isArgSpace(data[r])) {
+      char c = data[r++];
+      if (c == '\'' || c == '"') {
+        while (r < len && data[r] != c) {
+          if (c == '"' && data[r] == '\\' && r + 1 < len) {
+            r++;
           }
-          char* end;
-          char* value = shiftArgs(&argc, &argv);
-          long result = strtol(value, &end, 10);
+          data[w++] = data[r++];
+        }
+        // Unterminated quote lasts until the end of the file.
+        if (r < len) {
+          r++;
+        }
+      } else if (c == '\\' && r < len) {
+        data[w++] = data[r++];
+      } else {
+        data[w++] = c;
+      }
+    }
+
+    count++;
+    if (r < len) {
+      // Separator is consumed before it is overwritten.
+      r++;
+      data[w++] = '\0';
+    } else if (w < len) {
+      data[w++] = '\0';
+    }
+  }
+
+  *end = w;
+  return count;
+}
+
+static bool parseResponseFile(const FlagSet* fs, FlagContext* ctx,
+    char* arg, const FlagResponseFile* parent) {
+  int fd = open(arg + 1, O_RDONLY);
+  if (fd < 0) {
+    setError(ctx, FLAG_ERROR_CODE_OPEN_RESPONSE_FILE, arg);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    setError(ctx, FLAG_ERROR_CODE_OPEN_RESPONSE_FILE, arg);
+    return false;
+  }
+
+  FlagResponseFile file;
+  file.dev    = st.st_dev;
+  file.ino    = st.st_ino;
+  file.parent = parent;
+
+  for (const FlagResponseFile* it = parent; it != NULL; it = it->parent) {
+    if (it->dev == file.dev && it->ino == file.ino) {
+      close(fd);
+      setError(ctx, FLAG_ERROR_CODE_RESPONSE_FILE_CYCLE, arg);
+      return false;
+    }
+  }
+
+  size_t len = st.st_size;
+  if (len == 0) {
+    close(fd);
+    return true;
+  }
+
+  // @note: private writable mapping lets arguments be terminated in place
+  // without touching the file.
+  void* mapping = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    setError(ctx, FLAG_ERROR_CODE_OPEN_RESPONSE_FILE, arg);
+    return false;
+  }
+
+  char* data = CAST(char*, mapping);
+  retainMapping(ctx, data, len);
+
+  size_t end;
+  int argc = tokenizeArgs(data, len, &end);
+  if (argc == 0) {
+    return true;
+  }
+
+  char** argv = CAST(char**, arenaAlloc(&ctx->arena, argc * sizeof(char*)));
+  char*  ptr  = data;
+  for (int i = 0; i < argc - 1; i++) {
+    argv[i] = ptr;
+    ptr    += strlen(ptr) + 1;
+  }
+  // The last argument has no room for the null byte if it ends the file.
+  argv[argc - 1] = end == len && data[len - 1] != '\0' ?
+    stringDuplicate(ctx, ptr, data + len - ptr) : ptr;
 
-          if (end == value || result < INT_MIN || INT_MAX < result) {
-            setError(fs, FLAG_ERROR_CODE_INVALID_VALUE, conf->name);
-            return false;
-          }
+  return parseArgList(fs, ctx, argc, argv, &file);
+}
 
-          *((int*)conf->ptr) = (int)result;
-        } break;
-      case FLAG_TYPE_FLOAT:
-        {
-          if (argc == 0) {
-            setError(fs, FLAG_ERROR_CODE_MISSING_VALUE, conf->name);
-            return false;
-          }
-          char* end;
-          char* value = shiftArgs(&argc, &argv);
-          float result = strtof(value, &end);
+bool flagSetParse(FlagSet* fs, int argc, char** argv) {
+  fs->ctx.owner = fs;
+  bool ok = parseArgs(fs, &fs->ctx, argc, argv);
+  if (ok) {
+    publishAtomics(fs, &fs->ctx);
+  }
+  return ok;
+}
 
-          if (end == value) {
-            setError(fs, FLAG_ERROR_CODE_INVALID_VALUE, conf->name);
-            return false;
-          }
+bool flagContextParse(FlagContext* ctx, int argc, char** argv) {
+  return parseArgs(ctx->fs, ctx, argc, argv);
+}
 
-          *((float*)conf->ptr) = (float)result;
-        } break;
-      case FLAG_TYPE_DOUBLE:
-        {
-          if (argc == 0) {
-            setError(fs, FLAG_ERROR_CODE_MISSING_VALUE, conf->name);
-            return false;
-          }
-          char* end;
-          char* value = shiftArgs(&argc, &argv);
-          float result = strtod(value, &end);
+// parseInto sets field flags in base to their defaults and parses arguments
+// storing field flags into base.
+static bool parseInto(const FlagSet* fs, FlagContext* ctx, void* base, int argc, char** argv) {
+  assert(base != NULL);
 
-          if (end == value) {
-            setError(fs, FLAG_ERROR_CODE_INVALID_VALUE, conf->name);
-            return false;
-          }
+  for (int i = 0; i < fs->flags_len; i++) {
+    const Flag* flag = fs->flags + i;
+    if (flag->offset != FLAGS_NO_OFFSET) {
+      setDefault(flag, CAST(char*, base) + flag->offset);
+    }
+  }
 
-          *((double*)conf->ptr) = (double)result;
-        } break;
-      case FLAG_TYPE_TIME:
-        {
-          if (argc == 0) {
-            setError(fs, FLAG_ERROR_CODE_MISSING_VALUE, conf->name);
-            return false;
-          }
-          char* value = shiftArgs(&argc, &argv);
+  ctx->base = CAST(char*, base);
+  bool ok   = parseArgs(fs, ctx, argc, argv);
+  ctx->base = NULL;
 
-          struct tm result = { 0 };
-          if (strptime(value, FLAGS_TIME_FMT, &result) == value) {
-            setError(fs, FLAG_ERROR_CODE_INVALID_VALUE, conf->name);
-            return false;
-          }
+  return ok;
+}
 
-          *((time_t*)conf->ptr) = mktime(&result);
-        } break;
-    }
+bool flagSetParseInto(FlagSet* fs, void* base, int argc, char** argv) {
+  fs->ctx.owner = fs;
+  bool ok = parseInto(fs, &fs->ctx, base, argc, argv);
+  if (ok) {
+    publishAtomics(fs, &fs->ctx);
   }
+  return ok;
+}
 
-  return true;
+bool flagContextParseInto(FlagContext* ctx, void* base, int argc, char** argv) {
+  return parseInto(ctx->fs, ctx, base, argc, argv);
 }
 
-void flagSetPrintError(FlagSet* fs, FILE* stream) {
-  switch (fs->error_code) {
+// printError prints error of the context with usage of the flag set and exits.
+static void printError(const FlagSet* fs, const FlagContext* ctx, FILE* stream) {
+  switch (ctx->error_code) {
     case FLAG_ERROR_CODE_UNKNOWN:
-      fprintf(stream, "ERROR: unknown flag \"%s\"\n\n", fs->error_flag_name);
+      fprintf(stream, "ERROR: unknown flag \"%s\"\n\n", ctx->error_flag_name);
       break;
     case FLAG_ERROR_CODE_MISSING_VALUE:
-      fprintf(stream, "ERROR: missing value for flag \"%s\"\n\n", fs->error_flag_name);
+      fprintf(stream, "ERROR: missing value for flag \"%s\"\n\n", ctx->error_flag_name);
       break;
     case FLAG_ERROR_CODE_INVALID_VALUE:
-      fprintf(stream, "ERROR: invalid value for flag \"%s\"\n\n", fs->error_flag_name);
+      fprintf(stream, "ERROR: invalid value for flag \"%s\"\n\n", ctx->error_flag_name);
+      break;
+    case FLAG_ERROR_CODE_OPEN_RESPONSE_FILE:
+      fprintf(stream, "ERROR: failed to open response file \"%s\"\n\n", ctx->error_flag_name + 1);
+      break;
+    case FLAG_ERROR_CODE_RESPONSE_FILE_CYCLE:
+      fprintf(stream, "ERROR: response file \"%s\" includes itself\n\n", ctx->error_flag_name + 1);
+      break;
+    case FLAG_ERROR_CODE_FIELD_WITHOUT_TARGET:
+      fprintf(stream, "ERROR: flag \"%s\" is a struct field, parse it with flagSetParseInto\n\n", ctx->error_flag_name);
       break;
     case FLAG_ERROR_CODE_HELP:
       flagSetPrintUsage(fs, stream);
@@ -632,6 +3673,70 @@ void flagSetPrintError(FlagSet* fs, FILE* stream) {
   exit(1);
 }
 
+void flagSetPrintError(FlagSet* fs, FILE* stream) {
+  // Errors of the subcommand are printed with its usage.
+  if (fs->command != NULL && fs->command->fs->ctx.error_code != FLAG_ERROR_CODE_NONE) {
+    flagSetPrintError(fs->command->fs, stream);
+    return;
+  }
+
+  printError(fs, &fs->ctx, stream);
+}
+
+void flagContextPrintError(const FlagContext* ctx, FILE* stream) {
+  printError(ctx->fs, ctx, stream);
+}
+
+// contextValue returns value of the flag with the given name and type.
+static const FlagValue* contextValue(const FlagContext* ctx, const char* name, FlagType type) {
+  const Flag* flag = flagIndexLookup(ctx->fs, name, strlen(name));
+  assert(flag != NULL && "unknown flag");
+  assert(flag->type == type && "flag type mismatch");
+  (void)type;
+
+  return ctx->values + (flag - ctx->fs->flags);
+}
+
+bool flagContextBool(const FlagContext* ctx, const char* name) {
+  return contextValue(ctx, name, FLAG_TYPE_BOOL)->as_bool;
+}
+
+char* flagContextString(const FlagContext* ctx, const char* name) {
+  return contextValue(ctx, name, FLAG_TYPE_STRING)->as_string;
+}
+
+int flagContextInt(const FlagContext* ctx, const char* name) {
+  return contextValue(ctx, name, FLAG_TYPE_INT)->as_int;
+}
+
+float flagContextFloat(const FlagContext* ctx, const char* name) {
+  return contextValue(ctx, name, FLAG_TYPE_FLOAT)->as_float;
+}
+
+double flagContextDouble(const FlagContext* ctx, const char* name) {
+  return contextValue(ctx, name, FLAG_TYPE_DOUBLE)->as_double;
+}
+
+time_t flagContextTime(const FlagContext* ctx, const char* name) {
+  return contextValue(ctx, name, FLAG_TYPE_TIME)->as_time_t;
+}
+
+int64_t flagContextInt64(const FlagContext* ctx, const char* name) {
+  return contextValue(ctx, name, FLAG_TYPE_INT64)->as_int64;
+}
+
+uint64_t flagContextUint64(const FlagContext* ctx, const char* name) {
+  return contextValue(ctx, name, FLAG_TYPE_UINT64)->as_uint64;
+}
+
+size_t flagContextSize(const FlagContext* ctx, const char* name) {
+  return contextValue(ctx, name, FLAG_TYPE_SIZE)->as_size;
+}
+
+uint64_t flagContextBytes(const FlagContext* ctx, const char* name) {
+  return contextValue(ctx, name, FLAG_TYPE_BYTES)->as_uint64;
+}
+
 // Default flag set is a global flag set that will be used by the library  
 // functions that do not accept FlagSet as the first argument.
 static FlagSet global_flag_set;
@@ -644,6 +3749,10 @@ void flagIgnoreUnknown(bool ignore) {
   flagSetIgnoreUnknown(&global_flag_set, ignore);
 }
 
+void flagEnvPrefix(char* prefix) {
+  flagSetEnvPrefix(&global_flag_set, prefix);
+}
+
 
 void flagBoolVar(bool* dst,
     char* name, char short_name, char* description) {
@@ -675,10 +3784,160 @@ void flagTimeVar(time_t* dst,
   flagSetTimeVar(&global_flag_set, dst, name, short_name, default_value, description);
 }
 
+void flagInt64Var(int64_t* dst,
+    char* name, char short_name, int64_t default_value, char* description) {
+  flagSetInt64Var(&global_flag_set, dst, name, short_name, default_value, description);
+}
+
+void flagUint64Var(uint64_t* dst,
+    char* name, char short_name, uint64_t default_value, char* description) {
+  flagSetUint64Var(&global_flag_set, dst, name, short_name, default_value, description);
+}
+
+void flagSizeVar(size_t* dst,
+    char* name, char short_name, size_t default_value, char* description) {
+  flagSetSizeVar(&global_flag_set, dst, name, short_name, default_value, description);
+}
+
+void flagBytesVar(uint64_t* dst,
+    char* name, char short_name, uint64_t default_value, char* description) {
+  flagSetBytesVar(&global_flag_set, dst, name, short_name, default_value, description);
+}
+
+#ifndef FLAGS_NO_ATOMICS
+void flagAtomicBoolVar(FlagAtomicBool* dst,
+    char* name, char short_name, char* description) {
+  flagSetAtomicBoolVar(&global_flag_set, dst, name, short_name, description);
+}
+
+void flagAtomicStringVar(FlagAtomicString* dst,
+    char* name, char short_name, char* default_value, char* description) {
+  flagSetAtomicStringVar(&global_flag_set, dst, name, short_name, default_value, description);
+}
+
+void flagAtomicIntVar(FlagAtomicInt* dst,
+    char* name, char short_name, int default_value, char* description) {
+  flagSetAtomicIntVar(&global_flag_set, dst, name, short_name, default_value, description);
+}
+
+void flagAtomicFloatVar(FlagAtomicFloat* dst,
+    char* name, char short_name, float default_value, char* description) {
+  flagSetAtomicFloatVar(&global_flag_set, dst, name, short_name, default_value, description);
+}
+
+void flagAtomicDoubleVar(FlagAtomicDouble* dst,
+    char* name, char short_name, double default_value, char* description) {
+  flagSetAtomicDoubleVar(&global_flag_set, dst, name, short_name, default_value, description);
+}
+
+void flagAtomicTimeVar(FlagAtomicTime* dst,
+    char* name, char short_name, time_t default_value, char* description) {
+  flagSetAtomicTimeVar(&global_flag_set, dst, name, short_name, default_value, description);
+}
+
+void flagAtomicInt64Var(FlagAtomicInt64* dst,
+    char* name, char short_name, int64_t default_value, char* description) {
+  flagSetAtomicInt64Var(&global_flag_set, dst, name, short_name, default_value, description);
+}
+
+void flagAtomicUint64Var(FlagAtomicUint64* dst,
+    char* name, char short_name, uint64_t default_value, char* description) {
+  flagSetAtomicUint64Var(&global_flag_set, dst, name, short_name, default_value, description);
+}
+
+void flagAtomicSizeVar(FlagAtomicSize* dst,
+    char* name, char short_name, size_t default_value, char* description) {
+  flagSetAtomicSizeVar(&global_flag_set, dst, name, short_name, default_value, description);
+}
+
+void flagAtomicBytesVar(FlagAtomicUint64* dst,
+    char* name, char short_name, uint64_t default_value, char* description) {
+  flagSetAtomicBytesVar(&global_flag_set, dst, name, short_name, default_value, description);
+}
+#endif
+
+void flagBoolField(size_t offset,
+    char* name, char short_name, char* description) {
+  flagSetBoolField(&global_flag_set, offset, name, short_name, description);
+}
+
+void flagStringField(size_t offset,
+    char* name, char short_name, char* default_value, char* description) {
+  flagSetStringField(&global_flag_set, offset, name, short_name, default_value, description);
+}
+
+void flagIntField(size_t offset,
+    char* name, char short_name, int default_value, char* description) {
+  flagSetIntField(&global_flag_set, offset, name, short_name, default_value, description);
+}
+
+void flagFloatField(size_t offset,
+    char* name, char short_name, float default_value, char* description) {
+  flagSetFloatField(&global_flag_set, offset, name, short_name, default_value, description);
+}
+
+void flagDoubleField(size_t offset,
+    char* name, char short_name, double default_value, char* description) {
+  flagSetDoubleField(&global_flag_set, offset, name, short_name, default_value, description);
+}
+
+void flagTimeField(size_t offset,
+    char* name, char short_name, time_t default_value, char* description) {
+  flagSetTimeField(&global_flag_set, offset, name, short_name, default_value, description);
+}
+
+void flagInt64Field(size_t offset,
+    char* name, char short_name, int64_t default_value, char* description) {
+  flagSetInt64Field(&global_flag_set, offset, name, short_name, default_value, description);
+}
+
+void flagUint64Field(size_t offset,
+    char* name, char short_name, uint64_t default_value, char* description) {
+  flagSetUint64Field(&global_flag_set, offset, name, short_name, default_value, description);
+}
+
+void flagSizeField(size_t offset,
+    char* name, char short_name, size_t default_value, char* description) {
+  flagSetSizeField(&global_flag_set, offset, name, short_name, default_value, description);
+}
+
+void flagBytesField(size_t offset,
+    char* name, char short_name, uint64_t default_value, char* description) {
+  flagSetBytesField(&global_flag_set, offset, name, short_name, default_value, description);
+}
+
 bool flagParse(int argc, char** argv) {
   return flagSetParse(&global_flag_set, argc, argv);
 }
 
+bool flagParseInto(void* base, int argc, char** argv) {
+  return flagSetParseInto(&global_flag_set, base, argc, argv);
+}
+
+int flagArgs(char*** args) {
+  return flagSetArgs(&global_flag_set, args);
+}
+
+void flagCommand(char* name, char* description, FlagCommandInit init, void* data) {
+  flagSetCommand(&global_flag_set, name, description, init, data);
+}
+
+FlagSet* flagSubcommand(void) {
+  return flagSetSubcommand(&global_flag_set);
+}
+
+bool flagOverride(const char* name, char* value) {
+  return flagSetOverride(&global_flag_set, name, value);
+}
+
+FlagSource flagSource(const char* name) {
+  return flagSetSource(&global_flag_set, name);
+}
+
+void flagReset(void) {
+  flagSetReset(&global_flag_set);
+}
+
 void flagPrintError(FILE* stream) {
   flagSetPrintError(&global_flag_set, stream);
 }
@@ -692,26 +3951,10 @@ void flagConfig(char* name, char short_name, char* description) {
   flagSetConfig(&global_flag_set, name, short_name, description);
 }
 
-static bool isConfigFlag(FlagSet* fs, char* flag) {
-  if (fs->config_flag_name == NULL) {
-    return false;
-  }
-
-  int len = strlen(flag);
-  if (len < 2 || flag[0] != '-') {
-    return false;
-  }
-
-  if (flag[1] == '-') {
-    // Long name is used
-    char* name = flag + 2;
-    return (strncmp(fs->config_flag_name, name, len - 2) == 0);
-  } else if (len == 2) {
-    return (fs->config_flag_short_name != '\0' &&
-        flag[1] == fs->config_flag_short_name);
-  }
-
-  return false;
+static bool isConfigName(const FlagSet* fs, const char* name, int len) {
+  return fs->config_flag_name != NULL &&
+    CAST(int, strlen(fs->config_flag_name)) == len &&
+    memcmp(fs->config_flag_name, name, len) == 0;
 }
 
 void flagSetConfig(FlagSet* fs, char* name, char short_name, char* description) {
@@ -722,136 +3965,335 @@ void flagSetConfig(FlagSet* fs, char* name, char short_name, char* description)
 
 #define CONFIG_BUFFER_SIZE 512
 
-static bool parseIniConfig(FlagSet* fs, const char* filename) {
-  char buf[CONFIG_BUFFER_SIZE] = {0};
+static void freeConfigs(FlagContext* ctx) {
+  for (int i = 0; i < ctx->configs_len; i++) {
+    iniParserFree(ctx->configs[i]);
+  }
+  ctx->configs_len = 0;
+}
 
-  IniParser* parser = iniParserOpen(filename);
-  if (parser == NULL) {
-    setError(fs, FLAG_ERROR_CODE_OPEN_CONFIG_FILE, fs->config_flag_name);
-    return false;
+// retainConfig keeps parser alive until the context is reset or freed.
+static void retainConfig(FlagContext* ctx, IniParser* parser) {
+  if (ctx->configs_len == ctx->configs_cap) {
+    ctx->configs_cap = ctx->configs_cap > 0 ? ctx->configs_cap * 2 : 4;
+    ctx->configs     = CAST(IniParser**,
+        realloc(ctx->configs, ctx->configs_cap * sizeof(IniParser*)));
   }
+  ctx->configs[ctx->configs_len++] = parser;
+}
+
+// sliceCopy copies slice into the buffer truncating it to fit and returns buffer.
+static char* sliceCopy(const IniSlice* slice, char* buf, int maxlen) {
+  int len = (slice->len < maxlen - 1) ? slice->len : maxlen - 1;
+  memcpy(buf, slice->ptr, len);
+  buf[len] = '\0';
+  return buf;
+}
+
+// parseIniValues populates flags from the parser.
+static bool parseIniValues(const FlagSet* fs, FlagContext* ctx, IniParser* parser) {
+  char buf[CONFIG_BUFFER_SIZE];
 
-  while (iniParseKey(parser, buf, FLAGS_FLAG_MAX_LEN) > 0) {
-    Flag* conf;
+  IniSlice key;
+  IniSlice value;
 
-    if (fs->config_flag_name && strcmp(fs->config_flag_name, buf) == 0) {
-      if (!iniParseValue(parser, buf, CONFIG_BUFFER_SIZE)) {
-        setError(fs, FLAG_ERROR_CODE_MISSING_VALUE, buf);
+  while (iniParseKeySlice(parser, &key) > 0) {
+    const Flag* conf;
 
-        iniParserFree(parser);
+    if (fs->config_flag_name && CAST(int, strlen(fs->config_flag_name)) == key.len &&
+        strncmp(fs->config_flag_name, key.ptr, key.len) == 0) {
+      if (!iniParseValueSlice(parser, &value)) {
+        setError(ctx, FLAG_ERROR_CODE_MISSING_VALUE, fs->config_flag_name);
         return false;
       }
 
-      if (!parseIniConfig(fs, buf)) {
+      char* filename = iniParserTerminate(parser, &value);
+      if (filename == NULL) {
+        filename = sliceCopy(&value, buf, CONFIG_BUFFER_SIZE);
+      }
+
+      if (!parseIniConfig(fs, ctx, filename)) {
         return false;
       }
 
-      memset(buf, 0, CONFIG_BUFFER_SIZE);
       continue;
     }
 
-    if (!lookupConfigFlag(fs, &conf, buf)) {
+    if (!lookupConfigFlag(fs, &conf, key.ptr, key.len)) {
       if (fs->ignore_unknown) {
-        memset(buf, 0, CONFIG_BUFFER_SIZE);
         continue;
       }
 
-      setError(fs, FLAG_ERROR_CODE_UNKNOWN, buf);
+      setError(ctx, FLAG_ERROR_CODE_UNKNOWN, sliceCopy(&key, buf, FLAGS_FLAG_MAX_LEN));
+      return false;
+    }
+
+    if (iniParseValueSlice(parser, &value) == 0) {
+      setError(ctx, FLAG_ERROR_CODE_MISSING_VALUE, conf->name);
+      return false;
+    }
 
-      iniParserFree(parser);
+    if (!flagHasStorage(ctx, conf)) {
+      setError(ctx, FLAG_ERROR_CODE_FIELD_WITHOUT_TARGET, conf->name);
       return false;
     }
 
-    memset(buf, 0, CONFIG_BUFFER_SIZE);
-    int value_len = 0;
+    // @note: values from the mapped file are terminated in place, so string
+    // flags point straight into the mapping.
+    void* dst = flagDestination(fs, ctx, conf, FLAG_SOURCE_CONFIG);
+    if (dst == NULL) {
+      // Flag is already set from the environment
+      continue;
+    }
+
+    char* str = iniParserTerminate(parser, &value);
 
-    if ((value_len = iniParseValue(parser, buf, CONFIG_BUFFER_SIZE)) == 0) {
-      setError(fs, FLAG_ERROR_CODE_MISSING_VALUE, conf->name);
+    if (conf->type == FLAG_TYPE_STRING) {
+      *((char**)dst) = str != NULL ? str : stringDuplicate(ctx, value.ptr, value.len);
+      continue;
+    }
+
+    if (str == NULL) {
+      str = sliceCopy(&value, buf, CONFIG_BUFFER_SIZE);
+    }
 
-      iniParserFree(parser);
+    if (!parseValue(conf->type, dst, str, &ctx->tz_offset)) {
+      setError(ctx, FLAG_ERROR_CODE_INVALID_VALUE, conf->name);
       return false;
     }
+  }
 
-    switch (conf->type) {
-      case FLAG_TYPE_BOOL:
-        {
-          if (strncmp(buf, "true", value_len) == 0) {
-            *((bool*)conf->ptr) = true;
-          } else if (strncmp(buf, "false", value_len) == 0) {
-            *((bool*)conf->ptr) = false;
-          } else {
-            setError(fs, FLAG_ERROR_CODE_INVALID_VALUE, conf->name);
-
-            iniParserFree(parser);
-            return false;
-          }
-        } break;
-      case FLAG_TYPE_STRING: 
-        {
-          *((char**)conf->ptr) = stringDuplicate(buf, value_len);
-        } break;
-      case FLAG_TYPE_INT:
-        {
-          char* end;
-          long result = strtol(buf, &end, 10);
+  return true;
+}
+
+// parseIniFile populates flags from the text of the configuration file.
+static bool parseIniFile(const FlagSet* fs, FlagContext* ctx, const char* filename) {
+  IniParser* parser = iniParserMap(filename);
+  if (parser != NULL) {
+    retainConfig(ctx, parser);
+    return parseIniValues(fs, ctx, parser);
+  }
 
-          if (end == buf || result < INT_MIN || INT_MAX < result) {
-            setError(fs, FLAG_ERROR_CODE_INVALID_VALUE, conf->name);
+  // Not a regular file, fallback to the stream parser.
+  parser = iniParserOpen(filename);
+  if (parser == NULL) {
+    // Flag sets loaded by flagWatchNew or flagSetCompileConfig may have no
+    // configuration flag.
+    setError(ctx, FLAG_ERROR_CODE_OPEN_CONFIG_FILE,
+        fs->config_flag_name != NULL ? fs->config_flag_name : filename);
+    return false;
+  }
 
-            iniParserFree(parser);
-            return false;
-          }
+  bool ok = parseIniValues(fs, ctx, parser);
+  iniParserFree(parser);
 
-          *((int*)conf->ptr) = (int)result;
-        } break;
-      case FLAG_TYPE_FLOAT:
-        {
-          char* end;
-          float result = strtof(buf, &end);
+  return ok;
+}
 
-          if (end == buf) {
-            setError(fs, FLAG_ERROR_CODE_INVALID_VALUE, conf->name);
+// snapshotName writes name of the snapshot of the configuration file into buf.
+// Returns false if the name does not fit.
+static bool snapshotName(const char* filename, char* buf, int size) {
+  int len = snprintf(buf, size, "%s%s", filename, FLAGS_SNAPSHOT_SUFFIX);
+  return len > 0 && len < size;
+}
 
-            iniParserFree(parser);
-            return false;
-          }
+static bool parseIniConfig(const FlagSet* fs, FlagContext* ctx, const char* filename) {
+  char        snapshot[CONFIG_BUFFER_SIZE];
+  struct stat config_st;
 
-          *((float*)conf->ptr) = (float)result;
-        } break;
-      case FLAG_TYPE_DOUBLE:
-        {
-          char* end;
-          float result = strtod(buf, &end);
+  // Snapshot is used only if it was compiled from the current file.
+  if (snapshotName(filename, snapshot, CONFIG_BUFFER_SIZE) &&
+      stat(filename, &config_st) == 0 &&
+      loadSnapshot(fs, ctx, snapshot, &config_st)) {
+    return true;
+  }
 
-          if (end == buf) {
-            setError(fs, FLAG_ERROR_CODE_INVALID_VALUE, conf->name);
+  return parseIniFile(fs, ctx, filename);
+}
 
-            iniParserFree(parser);
-            return false;
-          }
+bool flagSetCompileConfig(const FlagSet* fs, const char* filename) {
+  char snapshot[CONFIG_BUFFER_SIZE];
+  if (!snapshotName(filename, snapshot, CONFIG_BUFFER_SIZE)) {
+    return false;
+  }
 
-          *((double*)conf->ptr) = (double)result;
-        } break;
-      case FLAG_TYPE_TIME:
-        {
-          struct tm result = { 0 };
-          if (strptime(buf, FLAGS_TIME_FMT, &result) == buf) {
-            setError(fs, FLAG_ERROR_CODE_INVALID_VALUE, conf->name);
+  // @note: file is described before it is parsed, so changes made while it
+  // is parsed make the snapshot stale rather than wrong.
+  struct stat config_st;
+  if (stat(filename, &config_st) != 0) {
+    return false;
+  }
 
-            iniParserFree(parser);
-            return false;
-          }
+  FlagContext* ctx = flagContextNew(fs);
+  ctx->tz_offset = FLAGS_TZ_UNRESOLVED;
+  contextSources(fs, ctx);
 
-          *((time_t*)conf->ptr) = mktime(&result);
-        } break;
+  bool ok = parseIniFile(fs, ctx, filename) && writeSnapshot(fs, ctx, snapshot, &config_st);
+
+  flagContextFree(ctx);
+  return ok;
+}
+
+#if defined(__linux__) && !defined(FLAGS_NO_ATOMICS)
+
+#include <poll.h>
+#include <sys/inotify.h>
+
+// FlagWatch publishes every reload of the configuration file as a view.
+struct FlagWatch {
+  // Flag set of the configuration
+  const FlagSet* fs;
+  // Watched file, owned by the watch
+  char* filename;
+  // Name of the file inside its directory, points into filename
+  const char* basename;
+  // Inotify descriptor
+  int fd;
+  // Views of the published reloads.
+  FlagViewSlots published;
+  // Number of published reloads.
+  FLAGS_ATOMIC(unsigned long) version;
+  // Context of the last reload if it failed, it holds the error.
+  FlagContext* failed;
+};
+
+FlagWatch* flagWatchNew(const FlagSet* fs, const char* filename) {
+  FlagWatch* watch = CAST(FlagWatch*, calloc(1, sizeof(FlagWatch)));
+
+  size_t len = strlen(filename);
+  watch->fs       = fs;
+  watch->filename = CAST(char*, malloc(len + 1));
+  memcpy(watch->filename, filename, len + 1);
+
+  // @note: editors replace files by renaming, so the directory is watched
+  // instead of the file itself.
+  char* slash = strrchr(watch->filename, '/');
+  const char* dir = ".";
+  if (slash != NULL) {
+    *slash          = '\0';
+    dir             = slash == watch->filename ? "/" : watch->filename;
+    watch->basename = slash + 1;
+  } else {
+    watch->basename = watch->filename;
+  }
+
+  watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  bool ok   = watch->fd >= 0 &&
+    inotify_add_watch(watch->fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) >= 0;
+  if (slash != NULL) {
+    *slash = '/';
+  }
+
+  if (!ok) {
+    if (watch->fd >= 0) {
+      close(watch->fd);
+    }
+    free(watch->filename);
+    free(watch);
+    return NULL;
+  }
+
+  // Defaults are published until the file is loaded.
+  slotsPublish(&watch->published, flagContextFreeze(flagContextNew(fs)));
+
+  flagWatchReload(watch);
+  return watch;
+}
+
+void flagWatchFree(FlagWatch* watch) {
+  close(watch->fd);
+  slotsRelease(&watch->published);
+  if (watch->failed != NULL) {
+    flagContextFree(watch->failed);
+  }
+  free(watch->filename);
+  free(watch);
+}
+
+int flagWatchFd(const FlagWatch* watch) {
+  return watch->fd;
+}
+
+// watchDetach copies strings out of the mapped files and unmaps them, as the
+// files could be rewritten in place while their values are published.
+static void watchDetach(const FlagSet* fs, FlagContext* ctx) {
+  for (int i = 0; i < fs->flags_len; i++) {
+    if (fs->flags[i].type == FLAG_TYPE_STRING && ctx->sources[i] != FLAG_SOURCE_DEFAULT) {
+      char* str = ctx->values[i].as_string;
+      ctx->values[i].as_string = stringDuplicate(ctx, str, strlen(str));
     }
+  }
+
+  freeMappings(ctx);
+  freeConfigs(ctx);
+}
+
+bool flagWatchReload(FlagWatch* watch) {
+  // @note: every reload is parsed into its own context, that is owned by the
+  // view once published, so strings live as long as readers hold the view.
+  FlagContext* ctx = flagContextNew(watch->fs);
+  contextSources(watch->fs, ctx);
+  ctx->tz_offset = FLAGS_TZ_UNRESOLVED;
 
-    memset(buf, 0, CONFIG_BUFFER_SIZE);
+  if (watch->failed != NULL) {
+    flagContextFree(watch->failed);
+    watch->failed = NULL;
   }
 
+  if (!parseIniConfig(watch->fs, ctx, watch->filename)) {
+    watch->failed = ctx;
+    return false;
+  }
+
+  watchDetach(watch->fs, ctx);
+  slotsPublish(&watch->published, flagContextFreeze(ctx));
+  FLAGS_ATOMIC_ADD(&watch->version, 1, release);
   return true;
 }
 
+bool flagWatchPoll(FlagWatch* watch, int timeout_ms) {
+  struct pollfd pfd = { watch->fd, POLLIN, 0 };
+  if (poll(&pfd, 1, timeout_ms) <= 0) {
+    return false;
+  }
+
+  union {
+    struct inotify_event event;
+    char buf[4096];
+  } events;
+
+  bool changed = false;
+  ssize_t len;
+  while ((len = read(watch->fd, events.buf, sizeof(events.buf))) > 0) {
+    for (char* p = events.buf; p < events.buf + len;) {
+      struct inotify_event* event = CAST(struct inotify_event*, CAST(void*, p));
+      if (event->len > 0 && strcmp(event->name, watch->basename) == 0) {
+        changed = true;
+      }
+      p += sizeof(struct inotify_event) + event->len;
+    }
+  }
+
+  return changed && flagWatchReload(watch);
+}
+
+FlagErrorCode flagWatchError(const FlagWatch* watch) {
+  return watch->failed != NULL ? flagContextError(watch->failed) : FLAG_ERROR_CODE_NONE;
+}
+
+const char* flagWatchErrorFlag(const FlagWatch* watch) {
+  return watch->failed != NULL ? flagContextErrorFlag(watch->failed) : "";
+}
+
+unsigned long flagWatchVersion(const FlagWatch* watch) {
+  return FLAGS_ATOMIC_LOAD(&watch->version, acquire);
+}
+
+FlagView* flagWatchAcquire(FlagWatch* watch) {
+  return slotsAcquire(&watch->published);
+}
+
+#endif // __linux__
 #endif // WITH_INI
 #endif // FLAGS_IMPLEMENTATION
 #endif // FLAGS_H
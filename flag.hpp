@@ -0,0 +1,491 @@
+// Copyright 2025, Geogii Chernukhin <nk2ge5k@gmail.com>
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// C++14 front end for flag sets that are known at compile time.
+//
+// Flags are described by a constexpr table that carries a perfect hash over
+// long names and a direct short name table, so nothing is registered at
+// runtime. Arguments are tokenized by the same rules as flagSetParse and
+// values are converted with flagParseValue, so one of the translation units
+// still has to define FLAGS_IMPLEMENTATION.
+//
+//   static int  port    = 8080;
+//   static bool verbose = false;
+//
+//   constexpr auto flags = flag::makeTable({
+//     flag::Int(&port, "port", 'p', "Port to listen on"),
+//     flag::Bool(&verbose, "verbose", 'v', "Verbose output"),
+//   });
+//
+//   flag::Error err;
+//   if (!flag::parse(flags, argc, argv, &err)) {
+//     flag::printError(flags, err, stderr);
+//   }
+
+#ifndef FLAGS_HPP
+#define FLAGS_HPP
+
+#include "flag.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace flag {
+
+// Spec describes a single flag, it mirrors the Flag structure of flag.h.
+// Default value of the flag is the initial value of the destination.
+struct Spec {
+  // Type of flag
+  FlagType type;
+  // Flag name
+  const char* name;
+  // Short name of flag 0 - means no short name.
+  char short_name;
+  // Flag description
+  const char* description;
+  // Value pointer
+  void* ptr;
+};
+
+constexpr Spec Bool(bool* dst, const char* name, char short_name, const char* description) {
+  return Spec{FLAG_TYPE_BOOL, name, short_name, description, dst};
+}
+
+constexpr Spec String(char** dst, const char* name, char short_name, const char* description) {
+  return Spec{FLAG_TYPE_STRING, name, short_name, description, dst};
+}
+
+constexpr Spec Int(int* dst, const char* name, char short_name, const char* description) {
+  return Spec{FLAG_TYPE_INT, name, short_name, description, dst};
+}
+
+constexpr Spec Float(float* dst, const char* name, char short_name, const char* description) {
+  return Spec{FLAG_TYPE_FLOAT, name, short_name, description, dst};
+}
+
+constexpr Spec Double(double* dst, const char* name, char short_name, const char* description) {
+  return Spec{FLAG_TYPE_DOUBLE, name, short_name, description, dst};
+}
+
+constexpr Spec Time(time_t* dst, const char* name, char short_name, const char* description) {
+  return Spec{FLAG_TYPE_TIME, name, short_name, description, dst};
+}
+
+constexpr Spec Int64(int64_t* dst, const char* name, char short_name, const char* description) {
+  return Spec{FLAG_TYPE_INT64, name, short_name, description, dst};
+}
+
+constexpr Spec Uint64(uint64_t* dst, const char* name, char short_name, const char* description) {
+  return Spec{FLAG_TYPE_UINT64, name, short_name, description, dst};
+}
+
+constexpr Spec Size(size_t* dst, const char* name, char short_name, const char* description) {
+  return Spec{FLAG_TYPE_SIZE, name, short_name, description, dst};
+}
+
+constexpr Spec Bytes(uint64_t* dst, const char* name, char short_name, const char* description) {
+  return Spec{FLAG_TYPE_BYTES, name, short_name, description, dst};
+}
+
+// Error describes why parsing failed.
+struct Error {
+  // Error code
+  FlagErrorCode code = FLAG_ERROR_CODE_NONE;
+  // Name of the flag where error occurred
+  char flag_name[FLAGS_FLAG_MAX_LEN] = {};
+};
+
+namespace detail {
+
+constexpr std::size_t length(const char* s) {
+  std::size_t len = 0;
+  while (s[len] != '\0') {
+    len++;
+  }
+  return len;
+}
+
+constexpr bool equal(const char* a, const char* b, std::size_t len) {
+  for (std::size_t i = 0; i < len; i++) {
+    if (a[i] != b[i]) return false;
+  }
+  return a[len] == '\0';
+}
+
+// hash returns seeded FNV-1a hash of the string finalized with murmur3 mixer,
+// so that low bits used for the slot selection depend on the whole name.
+constexpr std::uint32_t hash(std::uint32_t seed, const char* s, std::size_t len) {
+  std::uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+  for (std::size_t i = 0; i < len; i++) {
+    h ^= static_cast<unsigned char>(s[i]);
+    h *= 16777619u;
+  }
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h;
+}
+
+constexpr std::size_t tableSize(std::size_t n) {
+  std::size_t size = 1;
+  while (size < n) {
+    size <<= 1;
+  }
+  return size;
+}
+
+} // namespace detail
+
+// Table is a compile time flag set. Long names are resolved with a two level
+// perfect hash (hash and displace): name selects a bucket and displacement
+// seed of the bucket selects the slot, which holds at most one flag.
+template <std::size_t N>
+class Table {
+ public:
+  // Number of slots, every slot holds at most one flag.
+  static constexpr std::size_t kSlots = detail::tableSize(N);
+  // Number of buckets, each bucket has its own displacement seed.
+  static constexpr std::size_t kBuckets = (N + 1) / 2;
+  // Maximum number of seeds tried for a single bucket.
+  static constexpr std::uint32_t kMaxSeed = 1u << 16;
+
+  constexpr explicit Table(const Spec (&specs)[N])
+    : specs_(), lengths_(), seeds_(), slots_(), shorts_() {
+    for (std::size_t i = 0; i < N; i++) {
+      specs_[i]   = specs[i];
+      lengths_[i] = detail::length(specs[i].name);
+
+      for (std::size_t j = 0; j < i; j++) {
+        if (lengths_[i] == lengths_[j] &&
+            detail::equal(specs_[i].name, specs_[j].name, lengths_[j])) {
+          throw "flag: duplicate flag name";
+        }
+      }
+
+      if (specs[i].short_name != 0) {
+        unsigned char c = static_cast<unsigned char>(specs[i].short_name);
+        if (shorts_[c] != 0) {
+          throw "flag: duplicate short flag name";
+        }
+        shorts_[c] = static_cast<std::uint16_t>(i + 1);
+      }
+    }
+
+    build();
+  }
+
+  // lookup returns flag with exactly matching long name or nullptr.
+  constexpr const Spec* lookup(const char* name, std::size_t len) const {
+    std::uint32_t bucket = detail::hash(0, name, len) % kBuckets;
+    std::uint32_t slot   = detail::hash(seeds_[bucket], name, len) & (kSlots - 1);
+
+    std::uint16_t i = slots_[slot];
+    if (i == 0 || lengths_[i - 1] != len || !detail::equal(specs_[i - 1].name, name, len)) {
+      return nullptr;
+    }
+    return specs_ + i - 1;
+  }
+
+  // lookupShort returns flag with the given short name or nullptr.
+  constexpr const Spec* lookupShort(char name) const {
+    std::uint16_t i = shorts_[static_cast<unsigned char>(name)];
+    return i == 0 ? nullptr : specs_ + i - 1;
+  }
+
+  constexpr std::size_t size() const { return N; }
+  constexpr const Spec* begin() const { return specs_; }
+  constexpr const Spec* end() const { return specs_ + N; }
+
+ private:
+  constexpr void build() {
+    std::uint32_t bucket_of[N] = {};
+    std::size_t   bucket_len[kBuckets] = {};
+    std::size_t   order[kBuckets] = {};
+
+    for (std::size_t i = 0; i < N; i++) {
+      bucket_of[i] = detail::hash(0, specs_[i].name, lengths_[i]) % kBuckets;
+      bucket_len[bucket_of[i]]++;
+    }
+
+    // Largest buckets are placed first while the table is still sparse.
+    for (std::size_t b = 0; b < kBuckets; b++) {
+      order[b] = b;
+    }
+    for (std::size_t i = 1; i < kBuckets; i++) {
+      for (std::size_t j = i; j > 0 && bucket_len[order[j - 1]] < bucket_len[order[j]]; j--) {
+        std::size_t tmp = order[j];
+        order[j]        = order[j - 1];
+        order[j - 1]    = tmp;
+      }
+    }
+
+    for (std::size_t k = 0; k < kBuckets && bucket_len[order[k]] > 0; k++) {
+      std::uint32_t bucket = static_cast<std::uint32_t>(order[k]);
+      std::uint32_t seed   = 1;
+
+      for (; seed < kMaxSeed; seed++) {
+        if (place(bucket_of, bucket, seed)) break;
+      }
+      if (seed == kMaxSeed) {
+        throw "flag: failed to build perfect hash";
+      }
+      seeds_[bucket] = seed;
+    }
+  }
+
+  // place attempts to put all flags of the bucket into free slots using the seed.
+  constexpr bool place(const std::uint32_t* bucket_of, std::uint32_t bucket, std::uint32_t seed) {
+    std::size_t placed = 0;
+
+    for (std::size_t i = 0; i < N; i++) {
+      if (bucket_of[i] != bucket) continue;
+
+      std::uint32_t slot = detail::hash(seed, specs_[i].name, lengths_[i]) & (kSlots - 1);
+      if (slots_[slot] != 0) {
+        // Roll back flags of the bucket that were already placed.
+        for (std::size_t j = 0; j < kSlots && placed > 0; j++) {
+          if (slots_[j] != 0 && bucket_of[slots_[j] - 1] == bucket) {
+            slots_[j] = 0;
+            placed--;
+          }
+        }
+        return false;
+      }
+
+      slots_[slot] = static_cast<std::uint16_t>(i + 1);
+      placed++;
+    }
+
+    return true;
+  }
+
+  Spec          specs_[N];
+  std::size_t   lengths_[N];
+  std::uint32_t seeds_[kBuckets];
+  std::uint16_t slots_[kSlots];
+  std::uint16_t shorts_[256];
+};
+
+// makeTable builds compile time flag set from the list of flags.
+template <std::size_t N>
+constexpr Table<N> makeTable(const Spec (&specs)[N]) {
+  return Table<N>(specs);
+}
+
+namespace detail {
+
+// setError populates err with the code and the first len bytes of the flag name.
+inline void setError(Error* err, FlagErrorCode code, const char* name, std::size_t len) {
+  if (len > FLAGS_FLAG_MAX_LEN - 1) {
+    len = FLAGS_FLAG_MAX_LEN - 1;
+  }
+  err->code = code;
+  std::memcpy(err->flag_name, name, len);
+  err->flag_name[len] = '\0';
+}
+
+// apply stores value of the flag, value is nullptr if it was not attached to
+// the flag. Bool flags take only attached values.
+inline bool apply(const Spec* conf, char* value, int* i, int argc, char** argv, Error* err) {
+  if (conf->type == FLAG_TYPE_BOOL && value == nullptr) {
+    *static_cast<bool*>(conf->ptr) = true;
+    return true;
+  }
+
+  if (value == nullptr) {
+    if (*i + 1 == argc) {
+      setError(err, FLAG_ERROR_CODE_MISSING_VALUE, conf->name, std::strlen(conf->name));
+      return false;
+    }
+    value = argv[++*i];
+  }
+
+  if (!flagParseValue(conf->type, conf->ptr, value)) {
+    setError(err, FLAG_ERROR_CODE_INVALID_VALUE, conf->name, std::strlen(conf->name));
+    return false;
+  }
+
+  return true;
+}
+
+// parseLong parses --name and --name=value arguments.
+template <std::size_t N>
+bool parseLong(const Table<N>& table, char* arg, int* i, int argc, char** argv,
+    Error* err, bool ignore_unknown) {
+  const char* name = arg + 2;
+  const char* eq   = std::strchr(name, '=');
+  std::size_t len  = eq != nullptr ? static_cast<std::size_t>(eq - name) : std::strlen(name);
+  char*       value = eq != nullptr ? arg + 2 + len + 1 : nullptr;
+
+  const Spec* conf = len > 0 ? table.lookup(name, len) : nullptr;
+  if (conf != nullptr) {
+    return apply(conf, value, i, argc, argv, err);
+  }
+
+  if (ignore_unknown) {
+    return true;
+  }
+
+  bool help = len == 4 && std::memcmp(name, "help", 4) == 0;
+  setError(err, help ? FLAG_ERROR_CODE_HELP : FLAG_ERROR_CODE_UNKNOWN, arg, len + 2);
+  return false;
+}
+
+// parseShort parses -a, clustered boolean flags -abc and short flags with
+// attached value -p8080.
+template <std::size_t N>
+bool parseShort(const Table<N>& table, char* arg, int* i, int argc, char** argv,
+    Error* err, bool ignore_unknown) {
+  for (char* c = arg + 1; *c != '\0'; c++) {
+    const char name[2] = { '-', *c };
+    // Rest of the argument after the flag is its value.
+    char* value = c[1] != '\0' ? c + 1 : nullptr;
+
+    const Spec* conf = table.lookupShort(*c);
+    if (conf == nullptr) {
+      // @note: the rest of the unknown cluster could be a value, so it is
+      // skipped as a whole.
+      if (ignore_unknown) {
+        return true;
+      }
+
+      setError(err, *c == 'h' ? FLAG_ERROR_CODE_HELP : FLAG_ERROR_CODE_UNKNOWN, name, 2);
+      return false;
+    }
+
+    if (conf->type != FLAG_TYPE_BOOL) {
+      return apply(conf, value, i, argc, argv, err);
+    }
+
+    apply(conf, nullptr, i, argc, argv, err);
+  }
+
+  return true;
+}
+
+} // namespace detail
+
+// parse attempts to parse flags from command line arguments. Long flags are
+// written as --name value or --name=value, short flags as -p value or -p8080,
+// boolean short flags could be combined as -abc and arguments that are not
+// flags or follow "--" are positional, same as flagSetParse. Positional
+// arguments are moved in place to argv + 1 and their number is stored into
+// args_len if it is not nullptr. Response files, environment variables and
+// configuration files are not supported. Returns false and populates err on
+// failure.
+// NOTE: positional arguments are moved in place, so order of argv changes.
+template <std::size_t N>
+bool parse(const Table<N>& table, int argc, char** argv,
+    Error* err, bool ignore_unknown = false, int* args_len = nullptr) {
+  // @note: positional arguments never outnumber the arguments that were
+  // read, so they are stored over the consumed ones.
+  int  args       = 0;
+  bool terminated = false;
+
+  for (int i = 1; i < argc; i++) {
+    char* arg = argv[i];
+    bool  ok  = true;
+
+    if (terminated || arg[0] != '-' || arg[1] == '\0') {
+      argv[1 + args++] = arg;
+    } else if (arg[1] != '-') {
+      ok = detail::parseShort(table, arg, &i, argc, argv, err, ignore_unknown);
+    } else if (arg[2] != '\0') {
+      ok = detail::parseLong(table, arg, &i, argc, argv, err, ignore_unknown);
+    } else {
+      // "--" terminates flags
+      terminated = true;
+    }
+
+    if (!ok) {
+      return false;
+    }
+  }
+
+  if (args_len != nullptr) {
+    *args_len = args;
+  }
+  return true;
+}
+
+// printUsage prints usage in the same format as flagSetPrintUsage, without
+// default values.
+template <std::size_t N>
+void printUsage(const Table<N>& table, FILE* stream) {
+  int max_flag_len = 0;
+  for (const Spec& flag : table) {
+    int len = static_cast<int>(std::strlen(flag.name));
+    if (len > max_flag_len) {
+      max_flag_len = len;
+    }
+  }
+
+  max_flag_len += 5;
+
+  std::fprintf(stream, "FLAGS\n");
+  for (const Spec& flag : table) {
+    if (flag.short_name != 0) {
+      std::fprintf(stream, "  -%c, ", flag.short_name);
+    } else {
+      std::fprintf(stream, "      ");
+    }
+    std::fprintf(stream, "--%-*s %s\n", max_flag_len, flag.name, flag.description);
+  }
+  std::fprintf(stream, "  -h, --%-*s Show this help message\n", max_flag_len, "help");
+
+  std::fprintf(stream, "\n");
+}
+
+// printError prints error if any present and exits, same as flagSetPrintError.
+template <std::size_t N>
+void printError(const Table<N>& table, const Error& err, FILE* stream) {
+  switch (err.code) {
+    case FLAG_ERROR_CODE_UNKNOWN:
+      std::fprintf(stream, "ERROR: unknown flag \"%s\"\n\n", err.flag_name);
+      break;
+    case FLAG_ERROR_CODE_MISSING_VALUE:
+      std::fprintf(stream, "ERROR: missing value for flag \"%s\"\n\n", err.flag_name);
+      break;
+    case FLAG_ERROR_CODE_INVALID_VALUE:
+      std::fprintf(stream, "ERROR: invalid value for flag \"%s\"\n\n", err.flag_name);
+      break;
+    case FLAG_ERROR_CODE_HELP:
+      printUsage(table, stream);
+      std::exit(0);
+      break;
+    default:
+      // Nothing to do
+      return;
+  }
+
+  printUsage(table, stream);
+
+  std::exit(1);
+}
+
+} // namespace flag
+
+#endif // FLAGS_HPP
@@ -23,6 +23,7 @@
 #define INI_PARSE_H
 
 #include <stdio.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,6 +37,9 @@ extern "C" {
 #define INI_MAX_LINE_SIZE 512
 #endif
 
+// Lines are scanned with SSE2 or AVX2 when the compiler targets them,
+// define INI_NO_SIMD to always use the portable 8 bytes at a time scanner.
+
 typedef enum {
   INI_ERROR_CODE_NONE = 0,
   // Buffer overflow - key or value size is greater then maximum allowed size
@@ -46,11 +50,28 @@ typedef enum {
 
 typedef struct IniParser IniParser;
 
+// IniSlice is a view into the parsed data, it is not null terminated.
+typedef struct {
+  // Pointer to the first byte
+  const char* ptr;
+  // Number of bytes
+  int len;
+} IniSlice;
+
 // iniParserNew creates new parser for the given file handler.
 IniParser* iniParserNew(FILE* file);
 // iniParserOpen opens given file for reading and creates new parser.
 // Returns NULL in case of error.
 IniParser* iniParserOpen(const char* filename);
+// iniParserMap maps given file into memory and creates new parser that reads
+// lines directly from the mapping without copying them.
+// The mapping is private, so it could be modified with iniParserTerminate
+// without affecting the file. Returns NULL in case of error or if the file
+// is not a regular file.
+IniParser* iniParserMap(const char* filename);
+// iniParserBuffer creates new parser for in-memory data.
+// @note: data is not copied and must outlive the parser.
+IniParser* iniParserBuffer(const char* data, size_t len);
 // iniParserFree closes the INI parser and frees allocated resources.
 // @note: If IniParser was created using iniParserNew, the file will not be closed.
 void iniParserFree(IniParser* parser);
@@ -65,6 +86,23 @@ int iniParseKey(IniParser* parser, char* dst, int maxlen);
 // only after iniParseKey.
 int iniParseValue(IniParser* parser, char* dst, int maxlen);
 
+// iniParseKeySlice points key to the next key without copying it.
+// Returns the length of the key, zero if no key is found or error code.
+// @note: For parsers created with iniParserMap and iniParserBuffer the slice
+// stays valid until the parser is freed, otherwise until the next call.
+int iniParseKeySlice(IniParser* parser, IniSlice* key);
+// iniParseValueSlice points value to the value of the key without copying it.
+// Values that span multiple lines are joined into the parser owned buffer
+// that is reused by the next multi-line value.
+// Returns the length of the value or zero if no value is found.
+// @note: must be called only after iniParseKeySlice or iniParseKey.
+int iniParseValueSlice(IniParser* parser, IniSlice* value);
+// iniParserTerminate null terminates slice in place if it points into the
+// private mapping of the parser created with iniParserMap.
+// Returns pointer to the terminated string that lives as long as the parser
+// or NULL if the slice could not be terminated in place.
+char* iniParserTerminate(IniParser* parser, const IniSlice* slice);
+
 #ifdef __cplusplus
 }
 #endif
@@ -72,10 +110,14 @@ int iniParseValue(IniParser* parser, char* dst, int maxlen);
 #ifdef INI_IMPLEMENTATION
 
 #include <assert.h>
-#include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #ifdef __cplusplus
 # define CAST(type, v) static_cast<type>(v)
@@ -83,38 +125,168 @@ int iniParseValue(IniParser* parser, char* dst, int maxlen);
 # define CAST(type, v) (type)(v)
 #endif
 
-static size_t stringLength(const char *s, size_t maxlen) {
-  for (size_t i = 0; i < maxlen; i++) {
-    if (s[i] == '\0') return i;
+#if !defined(INI_NO_SIMD) && defined(__GNUC__) && defined(__AVX2__)
+# include <immintrin.h>
+# define INI_VEC_SIZE 32
+# define INI_VEC_FULL 0xffffffffu
+typedef __m256i IniVec;
+# define iniVecLoad(p)   _mm256_loadu_si256((const __m256i*)(p))
+# define iniVecSet(c)    _mm256_set1_epi8(c)
+# define iniVecEq(a, b)  _mm256_cmpeq_epi8(a, b)
+# define iniVecOr(a, b)  _mm256_or_si256(a, b)
+# define iniVecSub(a, b) _mm256_sub_epi8(a, b)
+# define iniVecMin(a, b) _mm256_min_epu8(a, b)
+# define iniVecMask(v)   CAST(unsigned int, _mm256_movemask_epi8(v))
+#elif !defined(INI_NO_SIMD) && defined(__GNUC__) && defined(__SSE2__)
+# include <emmintrin.h>
+# define INI_VEC_SIZE 16
+# define INI_VEC_FULL 0xffffu
+typedef __m128i IniVec;
+# define iniVecLoad(p)   _mm_loadu_si128((const __m128i*)(p))
+# define iniVecSet(c)    _mm_set1_epi8(c)
+# define iniVecEq(a, b)  _mm_cmpeq_epi8(a, b)
+# define iniVecOr(a, b)  _mm_or_si128(a, b)
+# define iniVecSub(a, b) _mm_sub_epi8(a, b)
+# define iniVecMin(a, b) _mm_min_epu8(a, b)
+# define iniVecMask(v)   CAST(unsigned int, _mm_movemask_epi8(v))
+#endif
+
+// iniIsSpace matches the same characters as isspace in the "C" locale.
+static inline bool iniIsSpace(char c) {
+  return c == ' ' || CAST(unsigned char, c - '\t') <= '\r' - '\t';
+}
+
+#ifdef INI_VEC_SIZE
+
+// iniVecSpaceMask returns bit mask of the whitespace bytes in the vector.
+static inline unsigned int iniVecSpaceMask(IniVec v) {
+  // '\t' .. '\r' are the only bytes for which (v - '\t') <= 4 when unsigned.
+  IniVec shifted = iniVecSub(v, iniVecSet('\t'));
+  IniVec control = iniVecEq(iniVecMin(shifted, iniVecSet('\r' - '\t')), shifted);
+  return iniVecMask(iniVecOr(control, iniVecEq(v, iniVecSet(' '))));
+}
+
+#else
+
+#define INI_SWAR_ONES  0x0101010101010101ull
+#define INI_SWAR_HIGHS 0x8080808080808080ull
+
+static inline uint64_t iniSwarLoad(const char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// iniSwarHasZero returns non zero if any of the bytes is zero.
+static inline uint64_t iniSwarHasZero(uint64_t v) {
+  return (v - INI_SWAR_ONES) & ~v & INI_SWAR_HIGHS;
+}
+
+#endif
+
+// iniScanChar returns offset of the first c in buf or len if there is none.
+static size_t iniScanChar(const char* buf, size_t len, char c) {
+  size_t i = 0;
+
+#ifdef INI_VEC_SIZE
+  IniVec needle = iniVecSet(c);
+  for (; i + INI_VEC_SIZE <= len; i += INI_VEC_SIZE) {
+    unsigned int mask = iniVecMask(iniVecEq(iniVecLoad(buf + i), needle));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+#else
+  uint64_t needle = INI_SWAR_ONES * CAST(unsigned char, c);
+  for (; i + 8 <= len; i += 8) {
+    if (iniSwarHasZero(iniSwarLoad(buf + i) ^ needle)) {
+      break;
+    }
+  }
+#endif
+
+  for (; i < len; i++) {
+    if (buf[i] == c) return i;
   }
-  return maxlen;
+  return len;
 }
 
-static int lookupChar(const char* buf, int len, char c) {
-  for (int i = 0; i < len; i++) {
-    if (c == buf[i]) return i;
+// iniScanNonSpace returns offset of the first non whitespace byte or len.
+static size_t iniScanNonSpace(const char* buf, size_t len) {
+  size_t i = 0;
+
+#ifdef INI_VEC_SIZE
+  for (; i + INI_VEC_SIZE <= len; i += INI_VEC_SIZE) {
+    unsigned int mask = ~iniVecSpaceMask(iniVecLoad(buf + i)) & INI_VEC_FULL;
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+#else
+  uint64_t spaces = INI_SWAR_ONES * ' ';
+  while (i + 8 <= len && iniSwarLoad(buf + i) == spaces) {
+    i += 8;
+  }
+#endif
+
+  for (; i < len; i++) {
+    if (!iniIsSpace(buf[i])) return i;
   }
-  return -1;
+  return len;
 }
 
-static int trimRight(const char* src, int len) {
-  int i = len - 1;
-  for (; i >= 0; i--) {
-    if (!isspace(src[i])) return i + 1;
+// iniScanNonSpaceBack returns length of buf without trailing whitespace.
+static size_t iniScanNonSpaceBack(const char* buf, size_t len) {
+#ifdef INI_VEC_SIZE
+  for (; len >= INI_VEC_SIZE; len -= INI_VEC_SIZE) {
+    unsigned int mask = ~iniVecSpaceMask(iniVecLoad(buf + len - INI_VEC_SIZE)) & INI_VEC_FULL;
+    if (mask != 0) {
+      return len - INI_VEC_SIZE + (32 - __builtin_clz(mask));
+    }
+  }
+#else
+  uint64_t spaces = INI_SWAR_ONES * ' ';
+  while (len >= 8 && iniSwarLoad(buf + len - 8) == spaces) {
+    len -= 8;
+  }
+#endif
+
+  for (; len > 0; len--) {
+    if (!iniIsSpace(buf[len - 1])) return len;
   }
   return 0;
 }
 
+static size_t stringLength(const char *s, size_t maxlen) {
+  return iniScanChar(s, maxlen, '\0');
+}
+
+static int lookupChar(const char* buf, int len, char c) {
+  int i = iniScanChar(buf, len, c);
+  return i < len ? i : -1;
+}
+
+static int trimRight(const char* src, int len) {
+  return iniScanNonSpaceBack(src, len);
+}
+
 static int trimLeft(const char* src, int len) {
-  for (int i = 0; i < len; i++) {
-    if (!isspace(src[i])) return i;
-  }
-  return len;
+  return iniScanNonSpace(src, len);
 }
 
 struct IniParser {
-  // File that being parsed.
+  // File that being parsed, NULL if parser reads from data.
   FILE* file;
+  // Data that being parsed, either memory mapped file or in-memory buffer.
+  const char* data;
+  // Private writable mapping of the file, NULL for in-memory buffer.
+  char* mapping;
+  // Length of the data.
+  size_t data_len;
+  // Offset of the next line in the data.
+  size_t data_pos;
+  // Current line, points either into the line buffer or into the data.
+  const char* line_ptr;
   // Line cursor
   int cursor;
   // Length of the line.
@@ -125,6 +297,11 @@ struct IniParser {
   // @ugly: Flag that indicates that file should be closed with the parser.
   bool file_owned;
 
+  // Buffer for the values that span multiple lines.
+  char* joined;
+  // Capacity of the joined buffer.
+  int joined_cap;
+
   // Line buffer
   char line[INI_MAX_LINE_SIZE];
 };
@@ -137,6 +314,7 @@ IniParser* iniParserNew(FILE* file) {
 
   parser->file = file;
   parser->file_owned = false;
+  parser->line_ptr = parser->line;
 
   return parser;
 }
@@ -152,6 +330,50 @@ IniParser* iniParserOpen(const char* filename) {
 
   parser->file = file;
   parser->file_owned = true;
+  parser->line_ptr = parser->line;
+
+  return parser;
+}
+
+IniParser* iniParserMap(const char* filename) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return NULL;
+  }
+
+  char* data = NULL;
+  if (st.st_size > 0) {
+    void* mapping = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      close(fd);
+      return NULL;
+    }
+    data = CAST(char*, mapping);
+  }
+  close(fd);
+
+  IniParser* parser = CAST(IniParser*, malloc(sizeof(IniParser)));
+  memset(parser, 0, sizeof(IniParser));
+
+  parser->data     = data;
+  parser->mapping  = data;
+  parser->data_len = st.st_size;
+
+  return parser;
+}
+
+IniParser* iniParserBuffer(const char* data, size_t len) {
+  IniParser* parser = CAST(IniParser*, malloc(sizeof(IniParser)));
+  memset(parser, 0, sizeof(IniParser));
+
+  parser->data     = data;
+  parser->data_len = len;
 
   return parser;
 }
@@ -161,16 +383,34 @@ void iniParserFree(IniParser* parser) {
     if (parser->file_owned) {
       fclose(parser->file);
     }
+    if (parser->mapping != NULL) {
+      munmap(parser->mapping, parser->data_len);
+    }
+    free(parser->joined);
     free(parser);
   }
 }
 
-// iniParserConsume reads next line from the file.
+// iniParserConsume reads next line from the file or data.
 static bool iniParserConsume(IniParser* parser) {
   parser->cursor   = 0;
   parser->line_len = 0;
 
-  memset(parser->line, 0, INI_MAX_LINE_SIZE);
+  if (parser->file == NULL) {
+    if (parser->data_pos >= parser->data_len) {
+      return false;
+    }
+
+    const char* begin = parser->data + parser->data_pos;
+    size_t      rest  = parser->data_len - parser->data_pos;
+    size_t      len   = iniScanChar(begin, rest, '\n');
+
+    parser->data_pos += len + (len < rest);
+    parser->line_ptr  = begin;
+    parser->line_len  = trimRight(begin, len);
+
+    return true;
+  }
 
   if (fgets(parser->line, INI_MAX_LINE_SIZE, parser->file) == NULL) {
     return false;
@@ -194,7 +434,7 @@ static const char* iniParserLine(IniParser* parser, int* len) {
     return NULL;
   }
 
-  int begin = trimLeft(parser->line + parser->cursor, parser->line_len);
+  int begin = trimLeft(parser->line_ptr + parser->cursor, parser->line_len);
 
   parser->cursor   += begin;
   parser->line_len -= begin;
@@ -207,13 +447,10 @@ static const char* iniParserLine(IniParser* parser, int* len) {
     return NULL;
   }
 
-  return (parser->line + parser->cursor);
+  return (parser->line_ptr + parser->cursor);
 }
 
-int iniParseKey(IniParser* parser, char* dst, int maxlen) {
-  // @note: accounting for the '\0' at the end
-  maxlen--;
-
+int iniParseKeySlice(IniParser* parser, IniSlice* key) {
   while (iniParserConsume(parser)) {
     int length;
     const char* line = iniParserLine(parser, &length);
@@ -230,26 +467,38 @@ int iniParseKey(IniParser* parser, char* dst, int maxlen) {
     parser->cursor   += separator + 1;
     parser->line_len -= separator + 1;
 
-    int key_len = trimRight(line, separator);
-    if (key_len > maxlen) {
-      return INI_ERROR_CODE_OVERFLOW;
-    }
-
     // @todo: would be nice to normalize key for the following cases
     // - "key" = ...
     // - key . subkey = ...
 
-    strncpy(dst, line, key_len);
-    dst[key_len] = '\0';
+    key->ptr = line;
+    key->len = trimRight(line, separator);
 
-    return key_len;
+    return key->len;
   }
 
   // EOF
   return INI_ERROR_CODE_NONE;
 }
 
-int iniParseValue(IniParser* parser, char* dst, int maxlen) {
+// iniParserJoin appends len bytes of src to the joined buffer at offset.
+static void iniParserJoin(IniParser* parser, int offset, const char* src, int len) {
+  if (len == 0) {
+    return;
+  }
+
+  if (offset + len > parser->joined_cap) {
+    int cap = parser->joined_cap > 0 ? parser->joined_cap : INI_MAX_LINE_SIZE;
+    while (cap < offset + len) {
+      cap *= 2;
+    }
+    parser->joined     = CAST(char*, realloc(parser->joined, cap));
+    parser->joined_cap = cap;
+  }
+  memcpy(parser->joined + offset, src, len);
+}
+
+int iniParseValueSlice(IniParser* parser, IniSlice* value) {
   int length = 0;
   const char* line = iniParserLine(parser, &length);
 
@@ -257,49 +506,97 @@ int iniParseValue(IniParser* parser, char* dst, int maxlen) {
     return 0;
   }
 
-  // @note: accounting for the '\0' at the end
-  maxlen--;
-
   if (line[length - 1] != '\\') {
-    length = (length < maxlen) ? length : maxlen;
-    strncpy(dst, line, length);
-
-    dst[length] = '\0';
+    value->ptr = line;
+    value->len = length;
     return length;
   }
 
   int cursor = 0;
   bool more  = true;
-  while (more && length > 0 && maxlen > 0) {
+  while (more && length > 0) {
     more = line[length - 1] == '\\';
     if (more) {
       length = trimRight(line, length - 1);
     }
 
-    length = (length < maxlen) ? length : maxlen;
-    strncpy(dst + cursor, line, length);
-
-    cursor += length;
-    maxlen -= length;
-
-    if (maxlen > 0) {
-      dst[cursor] = ' ';
-
+    if (cursor > 0) {
+      iniParserJoin(parser, cursor, " ", 1);
       cursor++;
-      maxlen--;
     }
+    iniParserJoin(parser, cursor, line, length);
+    cursor += length;
 
-    if (more && maxlen > 0) {
-      iniParserConsume(parser);
+    if (more) {
+      if (!iniParserConsume(parser)) {
+        break;
+      }
       line = iniParserLine(parser, &length);
     }
   }
 
-  dst[cursor] = '\0';
+  value->ptr = parser->joined;
+  value->len = cursor;
 
   return cursor;
 }
 
+char* iniParserTerminate(IniParser* parser, const IniSlice* slice) {
+  if (parser->mapping == NULL) {
+    return NULL;
+  }
+
+  // @note: byte after the slice is either trailing space or line break that
+  // was already consumed, the last byte of the mapping has no such byte.
+  if (slice->ptr < parser->data ||
+      slice->ptr + slice->len >= parser->data + parser->data_len) {
+    return NULL;
+  }
+
+  char* begin = parser->mapping + (slice->ptr - parser->data);
+  begin[slice->len] = '\0';
+
+  return begin;
+}
+
+int iniParseKey(IniParser* parser, char* dst, int maxlen) {
+  // @note: accounting for the '\0' at the end
+  maxlen--;
+
+  IniSlice key;
+  int key_len = iniParseKeySlice(parser, &key);
+  if (key_len <= 0) {
+    return key_len;
+  }
+
+  if (key_len > maxlen) {
+    return INI_ERROR_CODE_OVERFLOW;
+  }
+
+  memcpy(dst, key.ptr, key_len);
+  dst[key_len] = '\0';
+
+  return key_len;
+}
+
+int iniParseValue(IniParser* parser, char* dst, int maxlen) {
+  IniSlice value;
+  int length = iniParseValueSlice(parser, &value);
+
+  if (length == 0) {
+    return 0;
+  }
+
+  // @note: accounting for the '\0' at the end
+  maxlen--;
+
+  length = (length < maxlen) ? length : maxlen;
+  memcpy(dst, value.ptr, length);
+  dst[length] = '\0';
+
+  return length;
+}
+
 #endif
 
 #endif // INI_PARSE_H
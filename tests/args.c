@@ -0,0 +1,141 @@
+// Tokenizer of flagSetParse: long and short forms, clusters, "--",
+// positional arguments and response files.
+
+#define FLAGS_IMPLEMENTATION
+#include "flag.h"
+#include "tests/test.h"
+
+static FlagSet* fs;
+static int      port;
+static char*    name;
+static bool     verbose;
+static bool     extra;
+static bool     quiet;
+
+// parse resets the flag set and parses arguments, argv is NULL terminated.
+static bool parse(char** argv) {
+  int argc = 0;
+  while (argv[argc] != NULL) {
+    argc++;
+  }
+  flagSetReset(fs);
+  return flagSetParse(fs, argc, argv);
+}
+
+static FlagErrorCode errorOf(void) {
+  return fs->ctx.error_code;
+}
+
+static const char* errorFlag(void) {
+  return fs->ctx.error_flag_name;
+}
+
+static void testTokens(void) {
+  char* equal[] = { "test", "--port=8080", "--name=a=b", "-vx", NULL };
+  CHECK(parse(equal) && port == 8080 && strcmp(name, "a=b") == 0 && verbose && extra);
+
+  char* attached[] = { "test", "-vxp8080", "-nfoo", NULL };
+  CHECK(parse(attached) && port == 8080 && strcmp(name, "foo") == 0 && verbose && extra);
+
+  char* terminated[] = { "test", "-vp", "81", "--", "--port", "9", NULL };
+  CHECK(parse(terminated) && port == 81 && verbose);
+
+  char* booleans[] = { "test", "--quiet=false", "--verbose=true", NULL };
+  CHECK(parse(booleans) && !quiet && verbose);
+
+  char* empty[] = { "test", "--name=", NULL };
+  CHECK(parse(empty) && strcmp(name, "") == 0);
+
+  char* negative[] = { "test", "--port", "-5", NULL };
+  CHECK(parse(negative) && port == -5);
+}
+
+static void testErrors(void) {
+  char* invalid[] = { "test", "--verbose=maybe", NULL };
+  CHECK(!parse(invalid) && errorOf() == FLAG_ERROR_CODE_INVALID_VALUE);
+
+  char* prefix[] = { "test", "--por", "1", NULL };
+  CHECK(!parse(prefix) && errorOf() == FLAG_ERROR_CODE_UNKNOWN && strcmp(errorFlag(), "--por") == 0);
+
+  char* cluster[] = { "test", "-vz", NULL };
+  CHECK(!parse(cluster) && errorOf() == FLAG_ERROR_CODE_UNKNOWN && strcmp(errorFlag(), "-z") == 0);
+
+  char* help[] = { "test", "--help=1", NULL };
+  CHECK(!parse(help) && errorOf() == FLAG_ERROR_CODE_HELP && strcmp(errorFlag(), "--help") == 0);
+
+  char* missing[] = { "test", "-p", NULL };
+  CHECK(!parse(missing) && errorOf() == FLAG_ERROR_CODE_MISSING_VALUE);
+
+  char* no_name[] = { "test", "--=", NULL };
+  CHECK(!parse(no_name) && errorOf() == FLAG_ERROR_CODE_UNKNOWN);
+}
+
+static void testPositional(void) {
+  char** args;
+  char*  argv[] = { "test", "a", "-p", "1", "b", "-", "-v", "--", "-p", "c", NULL };
+  CHECK(parse(argv) && port == 1 && verbose);
+  CHECK(flagSetArgs(fs, &args) == 5 && args == argv + 1);
+  CHECK(strcmp(args[0], "a") == 0 && strcmp(args[1], "b") == 0 && strcmp(args[2], "-") == 0);
+  CHECK(strcmp(args[3], "-p") == 0 && strcmp(args[4], "c") == 0);
+  CHECK(strcmp(argv[0], "test") == 0);
+
+  flagSetReset(fs);
+  CHECK(flagSetArgs(fs, &args) == 0);
+}
+
+static void testResponseFile(void) {
+  char nested[32], file[32], arg[33], cycle[32], cycle_arg[33];
+  testWriteFile(nested, "-v --port 2 # trailing comment\n");
+  snprintf(arg, sizeof(arg), "@%s", nested);
+
+  char data[128];
+  snprintf(data, sizeof(data), "# comment\nfirst -n 'hello world'\n%s \"a \\\"q\\\" b\" -- -x", arg);
+  testWriteFile(file, data);
+  snprintf(arg, sizeof(arg), "@%s", file);
+
+  char** args;
+  char*  argv[] = { "test", "zero", arg, "last", NULL };
+  CHECK(parse(argv) && port == 2 && verbose && !extra && strcmp(name, "hello world") == 0);
+  // Positional arguments of response files follow the command line order.
+  CHECK(flagSetArgs(fs, &args) == 5);
+  CHECK(strcmp(args[0], "zero") == 0 && strcmp(args[1], "first") == 0);
+  CHECK(strcmp(args[2], "a \"q\" b") == 0 && strcmp(args[3], "-x") == 0);
+  CHECK(strcmp(args[4], "last") == 0);
+
+  // Value of the flag is never read as a response file.
+  char* literal[] = { "test", "--name", "@name", NULL };
+  CHECK(parse(literal) && strcmp(name, "@name") == 0);
+
+  testWriteFile(cycle, "-p 1\n");
+  snprintf(cycle_arg, sizeof(cycle_arg), "@%s", cycle);
+  FILE* f = fopen(cycle, "a");
+  CHECK(f != NULL);
+  fprintf(f, "%s\n", cycle_arg);
+  fclose(f);
+  char* cyclic[] = { "test", cycle_arg, NULL };
+  CHECK(!parse(cyclic) && errorOf() == FLAG_ERROR_CODE_RESPONSE_FILE_CYCLE);
+
+  char* absent[] = { "test", "@/nonexistent/flag_test", NULL };
+  CHECK(!parse(absent) && errorOf() == FLAG_ERROR_CODE_OPEN_RESPONSE_FILE);
+
+  unlink(nested);
+  unlink(file);
+  unlink(cycle);
+}
+
+int main(void) {
+  fs = flagSetNew();
+  flagSetIntVar(fs, &port, "port", 'p', 80, "port");
+  flagSetStringVar(fs, &name, "name", 'n', "def", "name");
+  flagSetBoolVar(fs, &verbose, "verbose", 'v', "verbose");
+  flagSetBoolVar(fs, &extra, "extra", 'x', "extra");
+  flagSetBoolVar(fs, &quiet, "quiet", 0, "quiet");
+
+  testTokens();
+  testErrors();
+  testPositional();
+  testResponseFile();
+
+  flagSetFree(fs);
+  return 0;
+}
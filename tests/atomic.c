@@ -0,0 +1,121 @@
+// Atomic flags read by other threads while the flag set parses.
+
+#define FLAGS_IMPLEMENTATION
+#include "flag.h"
+#include "tests/test.h"
+
+#include <pthread.h>
+
+static FlagAtomicInt    timeout;
+static FlagAtomicDouble ratio;
+static FlagAtomicString name;
+static FlagAtomicBool   verbose;
+static FlagAtomicFloat  scale;
+static FlagAtomicTime   start;
+static FlagAtomicInt64  offset;
+static FlagAtomicUint64 limit;
+static FlagAtomicSize   workers;
+static int              stop;
+
+// reader checks that defaults are never published while the flag set is
+// reset and parsed again.
+static void* reader(void* arg) {
+  (void)arg;
+  while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+    CHECK(flagLoadInt(&timeout) != 7);
+    CHECK(flagLoadDouble(&ratio) == 0.75);
+    const char* str = flagLoadString(&name);
+    CHECK(str[0] == 'x' || str[0] == 'n');
+  }
+  return NULL;
+}
+
+static void testValues(FlagSet* fs) {
+  CHECK(flagLoadInt(&timeout) == 7 && flagLoadDouble(&ratio) == 0.5);
+  CHECK(strcmp(flagLoadString(&name), "x") == 0 && !flagLoadBool(&verbose));
+  CHECK(flagLoadFloat(&scale) == 1.5f && flagLoadTime(&start) == 10);
+  CHECK(flagLoadInt64(&offset) == -1 && flagLoadUint64(&limit) == 1 && flagLoadSize(&workers) == 2);
+
+  char* argv[] = { "test", "-t", "12", "-v", "--name", "nn", "--scale=2.5", "--ratio", "0.75",
+    "--offset", "-5000000000", "--limit", "18446744073709551615", "--workers", "8" };
+  CHECK(flagSetParse(fs, 15, argv));
+  CHECK(flagLoadInt(&timeout) == 12 && flagLoadDouble(&ratio) == 0.75);
+  CHECK(strcmp(flagLoadString(&name), "nn") == 0 && flagLoadBool(&verbose));
+  CHECK(flagLoadFloat(&scale) == 2.5f && flagLoadInt64(&offset) == -5000000000ll);
+  CHECK(flagLoadUint64(&limit) == UINT64_MAX && flagLoadSize(&workers) == 8);
+  CHECK(flagSetSource(fs, "timeout") == FLAG_SOURCE_ARGS);
+
+  FlagView* view = flagSetView(fs);
+  const FlagContext* ctx = flagViewContext(view);
+  CHECK(flagContextInt(ctx, "timeout") == 12 && flagContextDouble(ctx, "ratio") == 0.75);
+  CHECK(strcmp(flagContextString(ctx, "name"), "nn") == 0 && flagContextBool(ctx, "verbose"));
+  CHECK(flagContextUint64(ctx, "limit") == UINT64_MAX);
+  flagViewRelease(view);
+}
+
+static void testReset(FlagSet* fs) {
+  // Values stay published until the next parse, parsed strings excepted.
+  flagSetReset(fs);
+  CHECK(flagLoadInt(&timeout) == 12 && flagLoadBool(&verbose));
+  CHECK(strcmp(flagLoadString(&name), "x") == 0);
+
+  char* argv[] = { "test" };
+  CHECK(flagSetParse(fs, 1, argv));
+  CHECK(flagLoadInt(&timeout) == 7 && !flagLoadBool(&verbose) && flagLoadSize(&workers) == 2);
+}
+
+static void testFailed(FlagSet* fs) {
+  char* argv[] = { "test", "-t", "3", "--scale", "4" };
+  flagSetReset(fs);
+  CHECK(flagSetParse(fs, 5, argv));
+
+  // Flags before the bad argument are not published either.
+  char* bad_argv[] = { "test", "-t", "4", "-v", "--ratio", "bad", "--scale", "5" };
+  flagSetReset(fs);
+  CHECK(!flagSetParse(fs, 8, bad_argv));
+  CHECK(flagLoadInt(&timeout) == 3 && !flagLoadBool(&verbose));
+  CHECK(flagLoadDouble(&ratio) == 0.5 && flagLoadFloat(&scale) == 4);
+}
+
+static void testConcurrent(FlagSet* fs) {
+  char* argv[] = { "test", "--ratio", "0.75", "--name", "nn" };
+  flagSetReset(fs);
+  CHECK(flagSetOverride(fs, "timeout", "1"));
+  CHECK(flagSetParse(fs, 5, argv));
+
+  pthread_t thread;
+  CHECK(pthread_create(&thread, NULL, reader, NULL) == 0);
+
+  char buf[16];
+  for (int i = 1; i < 20000; i++) {
+    snprintf(buf, sizeof(buf), "%d", i % 5 + 1);
+    flagSetReset(fs);
+    CHECK(flagSetOverride(fs, "timeout", buf));
+    CHECK(flagSetParse(fs, 5, argv));
+    CHECK(flagLoadInt(&timeout) == i % 5 + 1);
+  }
+
+  __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+  pthread_join(thread, NULL);
+}
+
+int main(void) {
+  FlagSet* fs = flagSetNew();
+  flagSetAtomicIntVar(fs, &timeout, "timeout", 't', 7, "timeout");
+  flagSetAtomicDoubleVar(fs, &ratio, "ratio", 0, 0.5, "ratio");
+  flagSetAtomicStringVar(fs, &name, "name", 0, "x", "name");
+  flagSetAtomicBoolVar(fs, &verbose, "verbose", 'v', "verbose");
+  flagSetAtomicFloatVar(fs, &scale, "scale", 0, 1.5f, "scale");
+  flagSetAtomicTimeVar(fs, &start, "start", 0, 10, "start");
+  flagSetAtomicInt64Var(fs, &offset, "offset", 0, -1, "offset");
+  flagSetAtomicUint64Var(fs, &limit, "limit", 0, 1, "limit");
+  flagSetAtomicSizeVar(fs, &workers, "workers", 0, 2, "workers");
+
+  testValues(fs);
+  testReset(fs);
+  testFailed(fs);
+  testConcurrent(fs);
+
+  flagSetFree(fs);
+  return 0;
+}
@@ -0,0 +1,72 @@
+// Byte sizes with unit suffixes.
+
+#define FLAGS_IMPLEMENTATION
+#include "flag.h"
+#include "tests/test.h"
+
+static uint64_t cache;
+
+static bool parse(const char* str, uint64_t* dst) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%s", str);
+  return flagParseValue(FLAG_TYPE_BYTES, dst, buf);
+}
+
+static void testUnits(void) {
+  uint64_t v = 1;
+  CHECK(parse("0", &v) && v == 0);
+  v = 1;
+  CHECK(parse("0B", &v) && v == 0);
+  v = 1;
+  CHECK(parse("0b", &v) && v == 0);
+  CHECK(parse("0KiB", &v) && v == 0);
+  CHECK(parse("10B", &v) && v == 10);
+  CHECK(parse("+2 KB", &v) && v == 2000);
+  CHECK(parse("512MiB", &v) && v == 512ull << 20);
+  CHECK(parse("1_000kb", &v) && v == 1000000);
+  CHECK(parse("16EiB", &v) == false);
+  CHECK(parse("15EiB", &v) && v == 15ull << 60);
+  CHECK(parse("18446744073709551615", &v) && v == UINT64_MAX);
+}
+
+static void testInvalid(void) {
+  uint64_t v = 7;
+  // Base prefixes are not numbers of bytes.
+  CHECK(!parse("0x10", &v));
+  CHECK(!parse("0b1", &v));
+  CHECK(!parse("0o7", &v));
+  CHECK(!parse("", &v));
+  CHECK(!parse("B", &v));
+  CHECK(!parse("-1", &v));
+  CHECK(!parse("1 KIB", &v));
+  CHECK(!parse("1 bytes", &v));
+  CHECK(!parse("18446744073709551616", &v));
+  CHECK(v == 7);
+}
+
+static void testUsage(FlagSet* fs) {
+  // Default is printed as "0B" and parses back.
+  char   buf[4096];
+  FILE*  f = fmemopen(buf, sizeof(buf), "w");
+  CHECK(f != NULL);
+  flagSetPrintUsage(fs, f);
+  fclose(f);
+  CHECK(strstr(buf, "0B") != NULL);
+
+  char* argv[] = { "test", "--cache", "0B" };
+  cache = 1;
+  CHECK(flagSetParse(fs, 3, argv));
+  CHECK(cache == 0);
+}
+
+int main(void) {
+  FlagSet* fs = flagSetNew();
+  flagSetBytesVar(fs, &cache, "cache", 0, 0, "cache size");
+
+  testUnits();
+  testInvalid();
+  testUsage(fs);
+
+  flagSetFree(fs);
+  return 0;
+}
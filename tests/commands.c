@@ -0,0 +1,126 @@
+// Subcommands selected by the first positional argument.
+
+#define FLAGS_IMPLEMENTATION
+#include "flag.h"
+#include "tests/test.h"
+
+static FlagSet* fs;
+static bool     verbose;
+static int      port;
+static int      jobs;
+static int      serve_inits;
+static int      build_inits;
+
+static void serveFlags(FlagSet* sub, void* data) {
+  CHECK(data == &serve_inits);
+  serve_inits++;
+  flagSetIntVar(sub, &port, "port", 'p', 8080, "port");
+}
+
+static void buildFlags(FlagSet* sub, void* data) {
+  (void)data;
+  build_inits++;
+  flagSetIntVar(sub, &jobs, "jobs", 'j', 1, "jobs");
+}
+
+// errorOf returns error code of the last parse of the flag set.
+static FlagErrorCode errorOf(const FlagSet* set) {
+  return set->ctx.error_code;
+}
+
+static void testDispatch(void) {
+  char* argv[] = { "test", "-v", "serve", "--port", "9", "a", "b" };
+  CHECK(flagSetParse(fs, 7, argv));
+  CHECK(verbose && port == 9);
+  CHECK(serve_inits == 1 && build_inits == 0);
+
+  FlagSet* sub = flagSetSubcommand(fs);
+  CHECK(sub != NULL);
+  // Positional arguments after the subcommand belong to it.
+  char** args;
+  CHECK(flagSetArgs(fs, &args) == 0);
+  CHECK(flagSetArgs(sub, &args) == 2);
+  CHECK(strcmp(args[0], "a") == 0 && strcmp(args[1], "b") == 0);
+}
+
+static void testLazyInit(void) {
+  // Flags of the subcommand are registered once, no matter how many times
+  // it is selected.
+  char* argv[] = { "test", "serve", "-p", "10" };
+  for (int i = 0; i < 3; i++) {
+    flagSetReset(fs);
+    CHECK(flagSetParse(fs, 4, argv) && port == 10);
+  }
+  CHECK(serve_inits == 1 && build_inits == 0);
+
+  char* build_argv[] = { "test", "build", "-j", "4" };
+  flagSetReset(fs);
+  CHECK(flagSetParse(fs, 4, build_argv) && jobs == 4);
+  CHECK(serve_inits == 1 && build_inits == 1);
+  CHECK(flagSetSubcommand(fs) != NULL);
+}
+
+static void testPositional(void) {
+  // Subcommand is only selected by the first positional argument.
+  char* argv[] = { "test", "file", "serve" };
+  flagSetReset(fs);
+  CHECK(flagSetParse(fs, 3, argv));
+  CHECK(flagSetSubcommand(fs) == NULL);
+
+  char** args;
+  CHECK(flagSetArgs(fs, &args) == 2);
+  CHECK(strcmp(args[0], "file") == 0 && strcmp(args[1], "serve") == 0);
+
+  // Contexts treat subcommands as positional arguments.
+  char*        ctx_argv[] = { "test", "serve" };
+  FlagContext* ctx        = flagContextNew(fs);
+  CHECK(flagContextParse(ctx, 2, ctx_argv));
+  CHECK(flagContextArgs(ctx, &args) == 1 && strcmp(args[0], "serve") == 0);
+  flagContextFree(ctx);
+}
+
+static void testErrors(void) {
+  // Errors of the subcommand are reported by the parent.
+  char* argv[] = { "test", "serve", "--port", "abc" };
+  flagSetReset(fs);
+  CHECK(!flagSetParse(fs, 4, argv));
+  CHECK(errorOf(fs) == FLAG_ERROR_CODE_INVALID_VALUE);
+  CHECK(strcmp(fs->ctx.error_flag_name, "port") == 0);
+
+  // Flags of the parent are unknown after the subcommand.
+  char* unknown_argv[] = { "test", "build", "-v" };
+  flagSetReset(fs);
+  CHECK(!flagSetParse(fs, 3, unknown_argv));
+  CHECK(errorOf(fs) == FLAG_ERROR_CODE_UNKNOWN);
+}
+
+static void testReset(void) {
+  char* argv[] = { "test", "-v", "serve", "-p", "11" };
+  flagSetReset(fs);
+  CHECK(flagSetParse(fs, 5, argv) && port == 11);
+
+  // Reset of the parent resets the selected subcommand as well.
+  flagSetReset(fs);
+  CHECK(flagSetSubcommand(fs) == NULL);
+  CHECK(!verbose && port == 8080);
+
+  char* build_argv[] = { "test", "build" };
+  CHECK(flagSetParse(fs, 2, build_argv) && port == 8080);
+  CHECK(serve_inits == 1);
+}
+
+int main(void) {
+  fs = flagSetNew();
+  flagSetBoolVar(fs, &verbose, "verbose", 'v', "verbose");
+  flagSetCommand(fs, "serve", "serve", serveFlags, &serve_inits);
+  flagSetCommand(fs, "build", "build", buildFlags, NULL);
+
+  testDispatch();
+  testLazyInit();
+  testPositional();
+  testErrors();
+  testReset();
+
+  flagSetFree(fs);
+  return 0;
+}
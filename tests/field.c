@@ -0,0 +1,112 @@
+// Flags bound to struct fields.
+
+#define FLAGS_IMPLEMENTATION
+#include "flag.h"
+#include "tests/test.h"
+
+#include <stddef.h>
+
+typedef struct {
+  int    port;
+  bool   verbose;
+  char*  name;
+  double ratio;
+} Options;
+
+static FlagSet* newFlagSet(int* shared) {
+  FlagSet* fs = flagSetNew();
+  flagSetIntVar(fs, shared, "shared", 's', 3, "shared");
+  flagSetIntField(fs, offsetof(Options, port), "port", 'p', 80, "port");
+  flagSetBoolField(fs, offsetof(Options, verbose), "verbose", 'v', "verbose");
+  flagSetStringField(fs, offsetof(Options, name), "name", 'n', "def", "name");
+  flagSetDoubleField(fs, offsetof(Options, ratio), "ratio", 'r', 1.5, "ratio");
+  flagSetConfig(fs, "config", 'c', "config");
+  return fs;
+}
+
+static void testParseInto(void) {
+  int      shared = 0;
+  FlagSet* fs     = newFlagSet(&shared);
+  char     config[32];
+  testWriteFile(config, "port = 9\nname = ini\n");
+
+  Options a, b;
+  char*   args1[] = { "test", "--port", "1", "-v", "-s", "7" };
+  char*   args2[] = { "test", "-c", config, "--ratio", "2" };
+  CHECK(flagSetParseInto(fs, &a, 6, args1));
+  CHECK(flagSetParseInto(fs, &b, 5, args2));
+  CHECK(a.port == 1 && a.verbose && strcmp(a.name, "def") == 0 && a.ratio == 1.5);
+  CHECK(b.port == 9 && !b.verbose && strcmp(b.name, "ini") == 0 && b.ratio == 2);
+  CHECK(shared == 7);
+
+  FlagContext* ctx = flagContextNew(fs);
+  Options      c;
+  CHECK(flagContextParseInto(ctx, &c, 6, args1) && c.port == 1);
+  // Contexts store values of the field flags themselves.
+  flagContextReset(ctx);
+  CHECK(flagContextParse(ctx, 6, args1) && flagContextInt(ctx, "port") == 1);
+  flagContextFree(ctx);
+
+  unlink(config);
+  flagSetFree(fs);
+}
+
+// errorOf returns error code of the last parse of the flag set.
+static FlagErrorCode errorOf(const FlagSet* fs) {
+  return fs->ctx.error_code;
+}
+
+// Field flags set without the struct fail instead of writing through NULL.
+static void testWithoutTarget(void) {
+  int      shared = 0;
+  FlagSet* fs     = newFlagSet(&shared);
+  char*    args[] = { "test", "--port", "1" };
+  CHECK(!flagSetParse(fs, 3, args));
+  CHECK(errorOf(fs) == FLAG_ERROR_CODE_FIELD_WITHOUT_TARGET);
+
+  // Short and clustered boolean flags fail the same way as the long ones.
+  char* short_args[] = { "test", "-v" };
+  flagSetReset(fs);
+  CHECK(!flagSetParse(fs, 2, short_args));
+  CHECK(errorOf(fs) == FLAG_ERROR_CODE_FIELD_WITHOUT_TARGET);
+  CHECK(strcmp(fs->ctx.error_flag_name, "verbose") == 0);
+
+  bool extra = false;
+  flagSetBoolVar(fs, &extra, "extra", 'x', "extra");
+  char* cluster_args[] = { "test", "-xv" };
+  flagSetReset(fs);
+  CHECK(!flagSetParse(fs, 2, cluster_args));
+  CHECK(errorOf(fs) == FLAG_ERROR_CODE_FIELD_WITHOUT_TARGET);
+  CHECK(strcmp(fs->ctx.error_flag_name, "verbose") == 0);
+
+  flagSetReset(fs);
+  char* shared_args[] = { "test", "-s", "5" };
+  CHECK(flagSetParse(fs, 3, shared_args) && shared == 5);
+
+  char config[32];
+  testWriteFile(config, "name = ini\n");
+  char* config_args[] = { "test", "-c", config };
+  flagSetReset(fs);
+  CHECK(!flagSetParse(fs, 3, config_args));
+  CHECK(errorOf(fs) == FLAG_ERROR_CODE_FIELD_WITHOUT_TARGET);
+
+  flagSetReset(fs);
+  flagSetEnvPrefix(fs, "FIELD_TEST");
+  setenv("FIELD_TEST_RATIO", "3", 1);
+  CHECK(!flagSetParse(fs, 1, args));
+  CHECK(errorOf(fs) == FLAG_ERROR_CODE_FIELD_WITHOUT_TARGET);
+  unsetenv("FIELD_TEST_RATIO");
+
+  flagSetReset(fs);
+  CHECK(!flagSetOverride(fs, "port", "1"));
+  CHECK(flagSetOverride(fs, "shared", "9") && shared == 9);
+
+  unlink(config);
+  flagSetFree(fs);
+}
+
+int main(void) {
+  testParseInto();
+  testWithoutTarget();
+  return 0;
+}
@@ -0,0 +1,141 @@
+// Floating point values, the fast path and the strtod fallback.
+
+#define FLAGS_IMPLEMENTATION
+#include "flag.h"
+#include "tests/test.h"
+
+#include <locale.h>
+
+static bool parseDouble(const char* str, double* dst) {
+  char buf[256];
+  snprintf(buf, sizeof(buf), "%s", str);
+  return flagParseValue(FLAG_TYPE_DOUBLE, dst, buf);
+}
+
+static bool parseFloat(const char* str, float* dst) {
+  char buf[256];
+  snprintf(buf, sizeof(buf), "%s", str);
+  return flagParseValue(FLAG_TYPE_FLOAT, dst, buf);
+}
+
+// sameDouble tells that both values have the same bits, so -0 differs from 0.
+static bool sameDouble(double a, double b) {
+  return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+static bool sameFloat(float a, float b) {
+  return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+static void testRounding(void) {
+  double d = 0;
+  float  f = 0;
+  CHECK(parseDouble("0.1", &d) && d == 0.1);
+  CHECK(parseDouble("1e22", &d) && d == 1e22);
+  CHECK(parseDouble("123456789e-22", &d) && d == 123456789e-22);
+
+  // Halfway between two doubles rounds to the even one.
+  CHECK(parseDouble("9007199254740993", &d) && d == 9007199254740992.0);
+  CHECK(parseDouble("9007199254740995", &d) && d == 9007199254740996.0);
+  // Digits past the halfway point round up, even beyond the first 19.
+  CHECK(parseDouble("9007199254740993.00000000000000000001", &d) && d == 9007199254740994.0);
+  CHECK(parseFloat("16777217", &f) && f == 16777216.0f);
+  CHECK(parseFloat("16777219", &f) && f == 16777220.0f);
+  CHECK(parseFloat("1.00000005960464477539062500001", &f) && f == 1.00000011920928955078125f);
+
+  // Long mantissas take the fallback.
+  CHECK(parseDouble("0.1000000000000000055511151231257827021181583404541015625", &d) && d == 0.1);
+  CHECK(parseDouble("3.14159265358979323846264338327950288", &d) && d == 3.14159265358979323846);
+}
+
+static void testRange(void) {
+  double d = 0;
+  float  f = 0;
+  // Subnormals.
+  CHECK(parseDouble("4.9406564584124654e-324", &d) && d == 0x1p-1074);
+  CHECK(parseDouble("2.2250738585072009e-308", &d) && d == 0x0.fffffffffffffp-1022);
+  CHECK(parseFloat("1.4e-45", &f) && f == 0x1p-149f);
+  CHECK(parseDouble("1e-400", &d) && sameDouble(d, 0.0));
+  CHECK(parseDouble("-1e-400", &d) && sameDouble(d, -0.0));
+
+  // Overflow to infinity.
+  CHECK(parseDouble("1e400", &d) && d == INFINITY);
+  CHECK(parseDouble("-1e400", &d) && d == -INFINITY);
+  CHECK(parseDouble("1.7976931348623157e308", &d) && d == DBL_MAX);
+  CHECK(parseFloat("3.5e38", &f) && f == INFINITY);
+  CHECK(parseDouble("inf", &d) && d == INFINITY);
+  CHECK(parseDouble("-infinity", &d) && d == -INFINITY);
+  CHECK(parseDouble("nan", &d) && isnan(d));
+
+  // Negative zero keeps its sign on both paths.
+  CHECK(parseDouble("-0", &d) && sameDouble(d, -0.0));
+  CHECK(parseDouble("-0.000e5", &d) && sameDouble(d, -0.0));
+  CHECK(parseFloat("-0", &f) && sameFloat(f, -0.0f));
+  CHECK(parseDouble("0", &d) && sameDouble(d, 0.0));
+}
+
+static void testInvalid(void) {
+  const char* invalid[] = { "", "1e", "1e+", ".", "-", "+.", "e5", "1.5x", "1.5 ", " 1.5",
+    "--1", "1,5", "0x10", "1_0", "infinite", "1e5.5" };
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    double d = 7;
+    float  f = 7;
+    CHECK(!parseDouble(invalid[i], &d) && d == 7);
+    CHECK(!parseFloat(invalid[i], &f) && f == 7);
+  }
+}
+
+// testRandom compares both paths with strtod in the C locale.
+static void testRandom(void) {
+  srand(1);
+  char buf[64];
+  for (int i = 0; i < 100000; i++) {
+    // Short mantissas with small exponents take the fast path.
+    unsigned long long mantissa = CAST(unsigned long long, rand()) * RAND_MAX + rand();
+    mantissa >>= rand() % 64;
+    const char* sign     = rand() % 2 ? "-" : "";
+    int         exponent = rand() % 700 - 350;
+    if (rand() % 2) {
+      snprintf(buf, sizeof(buf), "%s%llu.%de%d", sign, mantissa, rand(), exponent);
+    } else {
+      snprintf(buf, sizeof(buf), "%s%llue%d", sign, mantissa, exponent % 40);
+    }
+
+    double d = 0;
+    float  f = 0;
+    CHECK(parseDouble(buf, &d) && sameDouble(d, strtod(buf, NULL)));
+    CHECK(parseFloat(buf, &f) && sameFloat(f, strtof(buf, NULL)));
+  }
+}
+
+static void testLocale(void) {
+  const char* locales[] = { "de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "ru_RU.UTF-8" };
+  bool        found     = false;
+  for (size_t i = 0; i < sizeof(locales) / sizeof(locales[0]) && !found; i++) {
+    found = setlocale(LC_NUMERIC, locales[i]) != NULL && localeconv()->decimal_point[0] == ',';
+  }
+  if (!found) {
+    fprintf(stderr, "floats: no locale with ',' radix, locale check skipped\n");
+    setlocale(LC_NUMERIC, "C");
+    return;
+  }
+
+  double d = 0;
+  CHECK(parseDouble("1.5", &d) && d == 1.5);
+  CHECK(!parseDouble("1,5", &d));
+  CHECK(parseDouble("0.1000000000000000055511151231257827021181583404541015625", &d) && d == 0.1);
+  CHECK(parseDouble("4.9406564584124654e-324", &d) && d == 0x1p-1074);
+  float f = 0;
+  CHECK(parseFloat("2.5e-3", &f) && f == 2.5e-3f);
+
+  setlocale(LC_NUMERIC, "C");
+}
+
+int main(void) {
+  testRounding();
+  testRange();
+  testInvalid();
+  testRandom();
+  testLocale();
+  return 0;
+}
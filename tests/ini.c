@@ -0,0 +1,267 @@
+// INI parser over files, mappings and buffers. The test is built with the
+// default scanners, with INI_NO_SIMD and with AVX2 where the host has it, and
+// every build is compared with the byte at a time reference below.
+
+#define INI_IMPLEMENTATION
+#include "ini.h"
+#include "tests/test.h"
+
+// Reference entry of the fixture, key and value are null terminated.
+typedef struct {
+  char key[INI_MAX_KEY_SIZE];
+  char value[4096];
+} Entry;
+
+#define ENTRIES_MAX 512
+
+static bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// trimmed returns bounds of the line without surrounding whitespace.
+static void trimmed(const char** begin, const char** end) {
+  while (*begin < *end && isSpace(**begin)) {
+    (*begin)++;
+  }
+  while (*end > *begin && isSpace((*end)[-1])) {
+    (*end)--;
+  }
+}
+
+// referenceParse splits data into entries the way the parser is documented to.
+static int referenceParse(const char* data, Entry* entries) {
+  int         count = 0;
+  const char* line  = data;
+  while (*line != '\0') {
+    const char* next = strchr(line, '\n');
+    next             = next != NULL ? next + 1 : line + strlen(line);
+    const char* end  = next;
+    trimmed(&line, &end);
+
+    if (line == end || *line == ';' || *line == '#') {
+      line = next;
+      continue;
+    }
+
+    const char* sep = CAST(const char*, memchr(line, '=', end - line));
+    CHECK(sep != NULL && count < ENTRIES_MAX);
+    Entry* entry = entries + count++;
+
+    const char* key_end = sep;
+    while (key_end > line && isSpace(key_end[-1])) {
+      key_end--;
+    }
+    memcpy(entry->key, line, key_end - line);
+    entry->key[key_end - line] = '\0';
+
+    // Lines ending with '\' continue on the next line, joined with a space.
+    // An empty line ends the value as well.
+    const char* value = sep + 1;
+    int         len   = 0;
+    bool        first = true;
+    for (;;) {
+      trimmed(&value, &end);
+      if (!first && value == end) {
+        line = next;
+        break;
+      }
+      bool more = end > value && end[-1] == '\\';
+      if (more) {
+        end--;
+        while (end > value && isSpace(end[-1])) {
+          end--;
+        }
+      }
+      if (len > 0) {
+        entry->value[len++] = ' ';
+      }
+      memcpy(entry->value + len, value, end - value);
+      len += end - value;
+
+      line  = next;
+      first = false;
+      if (!more || *line == '\0') {
+        break;
+      }
+      next  = strchr(line, '\n');
+      next  = next != NULL ? next + 1 : line + strlen(line);
+      value = line;
+      end   = next;
+    }
+    entry->value[len] = '\0';
+  }
+
+  return count;
+}
+
+// checkParser compares entries parsed by the parser with the reference.
+static void checkParser(IniParser* parser, const Entry* entries, int count) {
+  CHECK(parser != NULL);
+  for (int i = 0; i < count; i++) {
+    IniSlice key, value;
+    CHECK(iniParseKeySlice(parser, &key) == CAST(int, strlen(entries[i].key)));
+    CHECK(memcmp(key.ptr, entries[i].key, key.len) == 0);
+
+    int len = iniParseValueSlice(parser, &value);
+    CHECK(len == CAST(int, strlen(entries[i].value)));
+    CHECK(len == 0 || memcmp(value.ptr, entries[i].value, len) == 0);
+  }
+
+  IniSlice key;
+  CHECK(iniParseKeySlice(parser, &key) == INI_ERROR_CODE_NONE);
+  iniParserFree(parser);
+}
+
+// checkData parses data from the buffer, the mapping and the file.
+static void checkData(const char* data) {
+  static Entry entries[ENTRIES_MAX];
+  int          count = referenceParse(data, entries);
+  size_t       len   = strlen(data);
+
+  // @note: the buffer is copied into memory of its exact size, so sanitizers
+  // catch vector loads past its end.
+  char* copy = CAST(char*, malloc(len > 0 ? len : 1));
+  memcpy(copy, data, len);
+  checkParser(iniParserBuffer(copy, len), entries, count);
+  free(copy);
+
+  char path[32];
+  testWriteFile(path, data);
+  checkParser(iniParserMap(path), entries, count);
+  checkParser(iniParserOpen(path), entries, count);
+  unlink(path);
+}
+
+static void testFixtures(void) {
+  checkData("");
+  checkData("\n\n   \n");
+  checkData("key = value\n");
+  checkData("key=value");
+  checkData("  key  =   value with spaces  \r\n# comment\n; comment\nother =\n");
+  checkData("ab = 1\n\tcd\t=\t2\t\n\v\fef = 3 = 4\n");
+  checkData("list = one \\\n  two \\\n\tthree\nnext = 1\n");
+  checkData("list = one \\\n");
+  checkData("list = one \\");
+  checkData("list = \\\n\\\nlast\n");
+  checkData("list = a \\\n\n b = c\n");
+}
+
+// testBoundaries puts separators, whitespace runs and line breaks at every
+// offset around the 8, 16 and 32 byte boundaries of the scanners.
+static void testBoundaries(void) {
+  static char data[1 << 16];
+  for (int pad = 0; pad < 70; pad++) {
+    for (int spaces = 0; spaces < 40; spaces += 3) {
+      int len = 0;
+      len += snprintf(data + len, sizeof(data) - len, "%*skey%.*s%*s=%*s",
+          pad % 7, "", pad, "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijklmnopqr",
+          spaces, "", spaces % 5, "");
+      len += snprintf(data + len, sizeof(data) - len, "%.*s%*s\n",
+          pad + 1, "0123456789012345678901234567890123456789012345678901234567890123456789",
+          spaces, "");
+      len += snprintf(data + len, sizeof(data) - len, "%*s\t\n", pad, "");
+      len += snprintf(data + len, sizeof(data) - len, "k2 = %*sv \\%*s\n%*sw\n",
+          spaces, "", pad % 33, "", pad, "");
+      checkData(data);
+    }
+  }
+}
+
+static void testTerminate(void) {
+  const char* data = "name = first  \nempty =\nlast = end";
+  char        path[32];
+  testWriteFile(path, data);
+
+  IniParser* parser = iniParserMap(path);
+  IniSlice   key, value;
+  CHECK(iniParseKeySlice(parser, &key) == 4);
+  CHECK(iniParseValueSlice(parser, &value) == 5);
+  char* str = iniParserTerminate(parser, &value);
+  CHECK(str != NULL && strcmp(str, "first") == 0);
+  CHECK(strcmp(iniParserTerminate(parser, &key), "name") == 0);
+
+  CHECK(iniParseKeySlice(parser, &key) == 5);
+  CHECK(iniParseValueSlice(parser, &value) == 0);
+
+  // The last byte of the mapping has nothing after it to terminate.
+  CHECK(iniParseKeySlice(parser, &key) == 4);
+  CHECK(iniParseValueSlice(parser, &value) == 3);
+  CHECK(iniParserTerminate(parser, &value) == NULL);
+  iniParserFree(parser);
+  unlink(path);
+
+  // Only private mappings could be terminated.
+  parser = iniParserBuffer(data, strlen(data));
+  CHECK(iniParseKeySlice(parser, &key) == 4);
+  CHECK(iniParserTerminate(parser, &key) == NULL);
+  iniParserFree(parser);
+}
+
+static void testCopies(void) {
+  const char* data = "long_key = a \\\n b\nabc = 1234567\n=bad\n";
+
+  IniParser* parser = iniParserBuffer(data, strlen(data));
+  char       key[4], value[5];
+  CHECK(iniParseKey(parser, key, sizeof(key)) == INI_ERROR_CODE_OVERFLOW);
+
+  char long_key[16], joined[16];
+  iniParserFree(parser);
+  parser = iniParserBuffer(data, strlen(data));
+  CHECK(iniParseKey(parser, long_key, sizeof(long_key)) == 8 && strcmp(long_key, "long_key") == 0);
+  CHECK(iniParseValue(parser, joined, sizeof(joined)) == 3 && strcmp(joined, "a b") == 0);
+
+  // Values are truncated to fit.
+  CHECK(iniParseKey(parser, key, sizeof(key)) == 3 && strcmp(key, "abc") == 0);
+  CHECK(iniParseValue(parser, value, sizeof(value)) == 4 && strcmp(value, "1234") == 0);
+
+  CHECK(iniParseKey(parser, key, sizeof(key)) == INI_ERROR_INVALID_SYNTAX);
+  iniParserFree(parser);
+}
+
+// testScanners compares the scanners with byte loops at every offset and
+// length, the buffer is allocated with the exact size for sanitizers.
+static void testScanners(void) {
+  static const char alphabet[] = { ' ', '\t', '\n', '\v', '\f', '\r', '=', 'a', '\0', '\x80', '\xff', '\x0e' };
+  srand(1);
+  for (int round = 0; round < 200; round++) {
+    size_t len  = rand() % 130;
+    char*  buf  = CAST(char*, malloc(len > 0 ? len : 1));
+    char   fill = round % 2 == 0 ? ' ' : 'a';
+    // Long runs of one byte cross the vector boundaries.
+    for (size_t i = 0; i < len; i++) {
+      buf[i] = rand() % 8 == 0 ? alphabet[rand() % sizeof(alphabet)] : fill;
+    }
+
+    for (size_t off = 0; off <= len; off++) {
+      size_t      n = len - off;
+      const char* p = buf + off;
+
+      size_t eq = 0;
+      while (eq < n && p[eq] != '=') {
+        eq++;
+      }
+      size_t first = 0;
+      while (first < n && isSpace(p[first])) {
+        first++;
+      }
+      size_t last = n;
+      while (last > 0 && isSpace(p[last - 1])) {
+        last--;
+      }
+
+      CHECK(iniScanChar(p, n, '=') == eq);
+      CHECK(iniScanNonSpace(p, n) == first);
+      CHECK(iniScanNonSpaceBack(p, n) == last);
+    }
+    free(buf);
+  }
+}
+
+int main(void) {
+  testScanners();
+  testFixtures();
+  testBoundaries();
+  testTerminate();
+  testCopies();
+  return 0;
+}
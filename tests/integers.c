@@ -0,0 +1,103 @@
+// Boundaries of the integer flag types on the command line and in configs.
+
+#define FLAGS_IMPLEMENTATION
+#include "flag.h"
+#include "tests/test.h"
+
+static FlagSet* fs;
+static int      small;
+static int64_t  offset;
+static uint64_t limit;
+static size_t   workers;
+
+// parseArgv parses "--name value" with the flag set reset before.
+static bool parseArgv(const char* name, const char* value) {
+  char flag[32], buf[64];
+  snprintf(flag, sizeof(flag), "--%s", name);
+  snprintf(buf, sizeof(buf), "%s", value);
+
+  char* argv[] = { "test", flag, buf };
+  flagSetReset(fs);
+  return flagSetParse(fs, 3, argv);
+}
+
+// parseIni parses "name = value" from the configuration file.
+static bool parseIni(const char* name, const char* value) {
+  char path[32], data[128];
+  snprintf(data, sizeof(data), "%s = %s\n", name, value);
+  testWriteFile(path, data);
+
+  char* argv[] = { "test", "--config", path };
+  flagSetReset(fs);
+  bool ok = flagSetParse(fs, 3, argv);
+  unlink(path);
+  return ok;
+}
+
+// parseBoth checks that arguments and configuration agree.
+static bool parseBoth(const char* name, const char* value) {
+  bool     ok = parseArgv(name, value);
+  int      s  = small;
+  int64_t  o  = offset;
+  uint64_t l  = limit;
+  size_t   w  = workers;
+
+  CHECK(parseIni(name, value) == ok);
+  CHECK(!ok || (s == small && o == offset && l == limit && w == workers));
+  return ok;
+}
+
+static void testInt64(void) {
+  CHECK(parseBoth("offset", "9223372036854775807") && offset == INT64_MAX);
+  CHECK(parseBoth("offset", "-9223372036854775808") && offset == INT64_MIN);
+  CHECK(parseBoth("offset", "+9223372036854775807") && offset == INT64_MAX);
+  CHECK(parseBoth("offset", "0x7fffffffffffffff") && offset == INT64_MAX);
+  CHECK(!parseBoth("offset", "9223372036854775808"));
+  CHECK(!parseBoth("offset", "-9223372036854775809"));
+  CHECK(!parseBoth("offset", "18446744073709551616"));
+  CHECK(!parseBoth("offset", "-"));
+}
+
+static void testUint64(void) {
+  CHECK(parseBoth("limit", "18446744073709551615") && limit == UINT64_MAX);
+  CHECK(parseBoth("limit", "0xffff_ffff_ffff_ffff") && limit == UINT64_MAX);
+  CHECK(parseBoth("limit", "0") && limit == 0);
+  CHECK(!parseBoth("limit", "18446744073709551616"));
+  CHECK(!parseBoth("limit", "99999999999999999999"));
+  CHECK(!parseBoth("limit", "-1"));
+  CHECK(!parseBoth("limit", "-0"));
+}
+
+static void testSize(void) {
+  char max[32], over[32];
+  snprintf(max, sizeof(max), "%zu", SIZE_MAX);
+  snprintf(over, sizeof(over), "%zu0", SIZE_MAX);
+  CHECK(parseBoth("workers", max) && workers == SIZE_MAX);
+  CHECK(!parseBoth("workers", over));
+  CHECK(!parseBoth("workers", "-1"));
+  CHECK(!parseBoth("workers", "-18446744073709551615"));
+}
+
+static void testInt(void) {
+  CHECK(parseBoth("small", "2147483647") && small == INT_MAX);
+  CHECK(parseBoth("small", "-2147483648") && small == INT_MIN);
+  CHECK(!parseBoth("small", "2147483648"));
+  CHECK(!parseBoth("small", "-2147483649"));
+}
+
+int main(void) {
+  fs = flagSetNew();
+  flagSetIntVar(fs, &small, "small", 0, 0, "small");
+  flagSetInt64Var(fs, &offset, "offset", 0, 0, "offset");
+  flagSetUint64Var(fs, &limit, "limit", 0, 0, "limit");
+  flagSetSizeVar(fs, &workers, "workers", 0, 0, "workers");
+  flagSetConfig(fs, "config", 0, "config");
+
+  testInt64();
+  testUint64();
+  testSize();
+  testInt();
+
+  flagSetFree(fs);
+  return 0;
+}
@@ -0,0 +1,120 @@
+// Binary snapshots of the configuration file and of the parsed values.
+
+#define FLAGS_IMPLEMENTATION
+#include "flag.h"
+#include "tests/test.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+static int    port;
+static char*  name;
+static bool   verbose;
+static double ratio;
+static time_t start;
+
+static FlagSet* newFlagSet(bool extra) {
+  FlagSet* fs = flagSetNew();
+  flagSetIntVar(fs, &port, "port", 'p', 80, "port");
+  flagSetStringVar(fs, &name, "name", 'n', "def", "name");
+  flagSetBoolVar(fs, &verbose, "verbose", 'v', "verbose");
+  flagSetDoubleVar(fs, &ratio, "ratio", 0, 0, "ratio");
+  flagSetTimeVar(fs, &start, "start", 0, 0, "start");
+  if (extra) {
+    flagSetIntVar(fs, NULL, "extra", 0, 0, "extra");
+  }
+  flagSetConfig(fs, "config", 'c', "config");
+  return fs;
+}
+
+// rewrite replaces content of the file and sets its modification time.
+static void rewrite(const char* path, const char* data, struct timespec mtime) {
+  FILE* f = fopen(path, "w");
+  CHECK(f != NULL);
+  fputs(data, f);
+  fclose(f);
+  struct timespec times[2] = { mtime, mtime };
+  CHECK(utimensat(AT_FDCWD, path, times, 0) == 0);
+}
+
+// parseConfig resets the flag set and parses the configuration file.
+static bool parseConfig(FlagSet* fs, char* config) {
+  char* argv[] = { "test", "-c", config };
+  flagSetReset(fs);
+  return flagSetParse(fs, 3, argv);
+}
+
+static void testCompile(void) {
+  char config[32], snapshot[40];
+  testWriteFile(config, "port = 1\nname = from ini\nverbose = true\nratio = 0.25\n"
+      "start = 2020-01-01T00:00:00Z\n");
+  snprintf(snapshot, sizeof(snapshot), "%s%s", config, FLAGS_SNAPSHOT_SUFFIX);
+
+  FlagSet* fs = newFlagSet(false);
+  CHECK(flagSetCompileConfig(fs, config));
+  // Compiling does not change values of the flag set.
+  CHECK(port == 80 && strcmp(name, "def") == 0);
+
+  struct stat st;
+  CHECK(stat(config, &st) == 0);
+  struct timespec mtime = st.st_mtim;
+
+  // Snapshot is used while size and modification time are unchanged, even if
+  // the content is not.
+  rewrite(config, "port = 2\nname = from ini\nverbose = true\nratio = 0.25\n"
+      "start = 2020-01-01T00:00:00Z\n", mtime);
+  CHECK(parseConfig(fs, config));
+  CHECK(port == 1 && strcmp(name, "from ini") == 0 && verbose && ratio == 0.25);
+  CHECK(start == 1577836800 && flagSetSource(fs, "name") == FLAG_SOURCE_CONFIG);
+
+  // Edit within the same second invalidates the snapshot.
+  mtime.tv_nsec = mtime.tv_nsec == 0 ? 1 : mtime.tv_nsec - 1;
+  rewrite(config, "port = 3\nname = from ini\nverbose = true\nratio = 0.25\n"
+      "start = 2020-01-01T00:00:00Z\n", mtime);
+  CHECK(parseConfig(fs, config) && port == 3);
+
+  // So does the edit that changes only size.
+  CHECK(flagSetCompileConfig(fs, config));
+  rewrite(config, "port = 44\n", mtime);
+  CHECK(parseConfig(fs, config) && port == 44 && strcmp(name, "def") == 0);
+
+  // Snapshot of the different flags is ignored.
+  CHECK(flagSetCompileConfig(fs, config));
+  flagSetFree(fs);
+  fs = newFlagSet(true);
+  rewrite(config, "port = 55\n", mtime);
+  CHECK(parseConfig(fs, config) && port == 55);
+  flagSetFree(fs);
+
+  unlink(config);
+  unlink(snapshot);
+}
+
+static void testSaveLoad(void) {
+  char snapshot[32];
+  testWriteFile(snapshot, "");
+
+  FlagSet* fs     = newFlagSet(false);
+  char*    argv[] = { "test", "-p", "5", "--name", "saved" };
+  CHECK(flagSetParse(fs, 5, argv));
+  CHECK(flagSetSave(fs, snapshot));
+
+  flagSetReset(fs);
+  CHECK(flagSetLoad(fs, snapshot));
+  CHECK(port == 5 && strcmp(name, "saved") == 0 && !verbose);
+  CHECK(flagSetSource(fs, "port") == FLAG_SOURCE_ARGS);
+  CHECK(flagSetSource(fs, "verbose") == FLAG_SOURCE_DEFAULT);
+  flagSetFree(fs);
+
+  fs = newFlagSet(true);
+  CHECK(!flagSetLoad(fs, snapshot) && port == 80);
+  flagSetFree(fs);
+
+  unlink(snapshot);
+}
+
+int main(void) {
+  testCompile();
+  testSaveLoad();
+  return 0;
+}
@@ -0,0 +1,89 @@
+// Precedence of value sources: default, config, environment, arguments and
+// override.
+
+#define FLAGS_IMPLEMENTATION
+#include "flag.h"
+#include "tests/test.h"
+
+static FlagSet* fs;
+static int      port;
+static int      a;
+static int      b;
+static int      c;
+static char*    name;
+
+static void testPrecedence(void) {
+  char first[32], second[32];
+  testWriteFile(first, "port = 9\na = 2\nb = 2\nc = 2\nname = one\n");
+  // Invalid value of c is never parsed, environment takes precedence.
+  testWriteFile(second, "a = 3\nc = bad\n");
+  setenv("SOURCES_TEST_C", "4", 1);
+
+  char* argv[] = { "test", "--config", first, "--config", second, "--port", "5" };
+  CHECK(flagSetOverride(fs, "name", "override"));
+  CHECK(flagSetParse(fs, 7, argv));
+  CHECK(port == 5 && a == 3 && b == 2 && c == 4 && strcmp(name, "override") == 0);
+  CHECK(flagSetSource(fs, "port") == FLAG_SOURCE_ARGS);
+  CHECK(flagSetSource(fs, "a") == FLAG_SOURCE_CONFIG);
+  CHECK(flagSetSource(fs, "c") == FLAG_SOURCE_ENV);
+  CHECK(flagSetSource(fs, "name") == FLAG_SOURCE_OVERRIDE);
+  CHECK(strcmp(flagSourceName(flagSetSource(fs, "c")), "env") == 0);
+
+  flagSetReset(fs);
+  CHECK(flagSetSource(fs, "name") == FLAG_SOURCE_DEFAULT && strcmp(name, "def") == 0);
+
+  unsetenv("SOURCES_TEST_C");
+  unlink(first);
+  unlink(second);
+}
+
+static void testOverride(void) {
+  flagSetReset(fs);
+  CHECK(!flagSetOverride(fs, "unknown", "1"));
+
+  // Invalid override changes neither the value nor its source.
+  CHECK(!flagSetOverride(fs, "port", "abc"));
+  CHECK(port == 80 && flagSetSource(fs, "port") == FLAG_SOURCE_DEFAULT);
+  char* argv[] = { "test", "--port", "9090" };
+  CHECK(flagSetParse(fs, 3, argv));
+  CHECK(port == 9090 && flagSetSource(fs, "port") == FLAG_SOURCE_ARGS);
+
+  // Valid override wins over arguments parsed before and after it.
+  CHECK(flagSetOverride(fs, "port", "1") && port == 1);
+  flagSetReset(fs);
+  CHECK(flagSetOverride(fs, "port", "2"));
+  CHECK(flagSetParse(fs, 3, argv) && port == 2);
+
+  // String overrides are copied, the buffer could be reused at once.
+  char buf[16];
+  snprintf(buf, sizeof(buf), "first");
+  CHECK(flagSetOverride(fs, "name", buf));
+  snprintf(buf, sizeof(buf), "second");
+  CHECK(strcmp(name, "first") == 0);
+
+  FlagContext* ctx = flagContextNew(fs);
+  CHECK(!flagContextOverride(ctx, "port", "abc"));
+  CHECK(flagContextSource(ctx, "port") == FLAG_SOURCE_DEFAULT);
+  CHECK(flagContextOverride(ctx, "port", "3"));
+  CHECK(flagContextParse(ctx, 3, argv) && flagContextInt(ctx, "port") == 3);
+  CHECK(flagContextSource(ctx, "port") == FLAG_SOURCE_OVERRIDE);
+  CHECK(flagContextSource(ctx, "a") == FLAG_SOURCE_DEFAULT);
+  flagContextFree(ctx);
+}
+
+int main(void) {
+  fs = flagSetNew();
+  flagSetIntVar(fs, &port, "port", 'p', 80, "port");
+  flagSetIntVar(fs, &a, "a", 0, 1, "a");
+  flagSetIntVar(fs, &b, "b", 0, 1, "b");
+  flagSetIntVar(fs, &c, "c", 0, 1, "c");
+  flagSetStringVar(fs, &name, "name", 'n', "def", "name");
+  flagSetConfig(fs, "config", 0, "config");
+  flagSetEnvPrefix(fs, "SOURCES_TEST");
+
+  testPrecedence();
+  testOverride();
+
+  flagSetFree(fs);
+  return 0;
+}
@@ -0,0 +1,100 @@
+// Compile time flag tables of flag.hpp.
+
+#define FLAGS_IMPLEMENTATION
+#include "flag.hpp"
+#include "tests/test.h"
+
+static int      port;
+static bool     verbose;
+static bool     extra;
+static char*    name;
+static int64_t  offset;
+static uint64_t limit;
+
+static constexpr auto flags = flag::makeTable({
+  flag::Int(&port, "port", 'p', "port"),
+  flag::Bool(&verbose, "verbose", 'v', "verbose"),
+  flag::Bool(&extra, "extra", 'x', "extra"),
+  flag::String(&name, "name", 'n', "name"),
+  flag::Int64(&offset, "offset", 'o', "offset"),
+  flag::Bytes(&limit, "limit", 0, "limit"),
+});
+
+static void reset() {
+  port    = 80;
+  verbose = false;
+  extra   = false;
+  name    = nullptr;
+  offset  = 0;
+  limit   = 0;
+}
+
+static void testTokens() {
+  reset();
+  char* args[] = { "test", "--port=8080", "-vx", "-nfoo", "--offset", "-5000000000", "--limit=4KiB" };
+  flag::Error err;
+  CHECK(flag::parse(flags, 7, args, &err));
+  CHECK(port == 8080 && verbose && extra && std::strcmp(name, "foo") == 0);
+  CHECK(offset == -5000000000ll && limit == 4096);
+
+  reset();
+  char* attached[] = { "test", "-vp9090", "--verbose=false" };
+  CHECK(flag::parse(flags, 3, attached, &err));
+  CHECK(port == 9090 && !verbose);
+
+  reset();
+  char* terminated[] = { "test", "-p", "1", "--", "--port", "2" };
+  CHECK(flag::parse(flags, 6, terminated, &err));
+  CHECK(port == 1);
+}
+
+// Positional arguments are moved in place to the front of argv.
+static void testPositional() {
+  reset();
+  char* args[] = { "test", "a", "-p", "1", "b", "-", "--verbose", "--", "-x", "c" };
+  flag::Error err;
+  int         len = -1;
+  CHECK(flag::parse(flags, 10, args, &err, false, &len));
+  CHECK(port == 1 && verbose && !extra);
+  CHECK(len == 5);
+  CHECK(std::strcmp(args[1], "a") == 0 && std::strcmp(args[2], "b") == 0);
+  CHECK(std::strcmp(args[3], "-") == 0 && std::strcmp(args[4], "-x") == 0);
+  CHECK(std::strcmp(args[5], "c") == 0);
+
+  // Value of the ignored flag is positional.
+  char* ignored[] = { "test", "--bogus", "value" };
+  CHECK(flag::parse(flags, 3, ignored, &err, true, &len) && len == 1);
+  CHECK(std::strcmp(ignored[1], "value") == 0);
+}
+
+static void testErrors() {
+  flag::Error err;
+  char*       unknown[] = { "test", "--bogus=1" };
+  CHECK(!flag::parse(flags, 2, unknown, &err));
+  CHECK(err.code == FLAG_ERROR_CODE_UNKNOWN && std::strcmp(err.flag_name, "--bogus") == 0);
+
+  char* cluster[] = { "test", "-vq" };
+  CHECK(!flag::parse(flags, 2, cluster, &err));
+  CHECK(err.code == FLAG_ERROR_CODE_UNKNOWN && std::strcmp(err.flag_name, "-q") == 0);
+
+  char* missing[] = { "test", "-v", "--port" };
+  CHECK(!flag::parse(flags, 3, missing, &err));
+  CHECK(err.code == FLAG_ERROR_CODE_MISSING_VALUE && std::strcmp(err.flag_name, "port") == 0);
+
+  char* invalid[] = { "test", "--port=abc" };
+  CHECK(!flag::parse(flags, 2, invalid, &err));
+  CHECK(err.code == FLAG_ERROR_CODE_INVALID_VALUE && std::strcmp(err.flag_name, "port") == 0);
+
+  char* help[] = { "test", "--help" };
+  CHECK(!flag::parse(flags, 2, help, &err) && err.code == FLAG_ERROR_CODE_HELP);
+
+  char* ignored[] = { "test", "--bogus", "-q", "-p", "3" };
+  CHECK(flag::parse(flags, 5, ignored, &err, true) && port == 3);
+}
+
+int main() {
+  testTokens();
+  testPositional();
+  testErrors();
+  return 0;
+}
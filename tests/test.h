@@ -0,0 +1,32 @@
+// Helpers shared by the tests. Every test is a program that exits with
+// non-zero code on the first failed check.
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// CHECK fails the test if the condition does not hold.
+#define CHECK(cond)                                                          \
+  do {                                                                       \
+    if (!(cond)) {                                                           \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      exit(1);                                                               \
+    }                                                                        \
+  } while (0)
+
+// testWriteFile writes data into the new temporary file and stores its name
+// into path, that must hold at least 32 bytes.
+static inline void testWriteFile(char* path, const char* data) {
+  snprintf(path, 32, "/tmp/flag_test_XXXXXX");
+  int fd = mkstemp(path);
+  CHECK(fd >= 0);
+  FILE* f = fdopen(fd, "w");
+  CHECK(f != NULL);
+  fputs(data, f);
+  fclose(f);
+}
+
+#endif // TEST_H
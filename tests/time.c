@@ -0,0 +1,103 @@
+// Time values in the default layout, zone suffixes and the local offset.
+
+#define FLAGS_IMPLEMENTATION
+#include "flag.h"
+#include "tests/test.h"
+
+// 2024-01-01T00:00:00Z
+#define NEW_YEAR 1704067200
+// 2024-07-01T00:00:00Z
+#define MID_YEAR 1719792000
+
+static bool parse(const char* str, time_t* dst) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%s", str);
+  return flagParseValue(FLAG_TYPE_TIME, dst, buf);
+}
+
+static void testSuffixes(void) {
+  time_t t = 0;
+  CHECK(parse("2024-01-01T00:00:00Z", &t) && t == NEW_YEAR);
+  CHECK(parse("2024-01-01T00:00:00+05:30", &t) && t == NEW_YEAR - 19800);
+  CHECK(parse("2024-01-01T00:00:00+0530", &t) && t == NEW_YEAR - 19800);
+  CHECK(parse("2024-01-01T00:00:00-0800", &t) && t == NEW_YEAR + 28800);
+  CHECK(parse("2024-01-01T00:00:00-08:00", &t) && t == NEW_YEAR + 28800);
+  CHECK(parse("2024-01-01T00:00:00+05", &t) && t == NEW_YEAR - 18000);
+  CHECK(parse("2024-01-01T00:00:00-00:00", &t) && t == NEW_YEAR);
+  CHECK(parse("1969-12-31T23:59:59Z", &t) && t == -1);
+  CHECK(parse("2016-12-31T23:59:60Z", &t) && t == 1483228800);
+}
+
+static void testCalendar(void) {
+  time_t t = 0;
+  CHECK(parse("2024-02-29T12:00:00Z", &t) && t == NEW_YEAR + 59 * 86400 + 12 * 3600);
+  CHECK(parse("2000-02-29T00:00:00Z", &t));
+  CHECK(parse("2024-12-31T23:59:59Z", &t));
+
+  const char* invalid[] = {
+    "2023-02-29T00:00:00Z", "1900-02-29T00:00:00Z", "2024-02-30T00:00:00Z",
+    "2024-04-31T00:00:00Z", "2024-13-01T00:00:00Z", "2024-00-10T00:00:00Z",
+    "2024-01-00T00:00:00Z", "2024-01-01T24:00:00Z", "2024-01-01T00:60:00Z",
+    "2024-01-01T00:00:61Z", "2024-1-01T00:00:00Z",  "2024-01-01 00:00:00Z",
+    "2024-01-01T00:00:00+24:00", "2024-01-01T00:00:00+05:60",
+    "2024-01-01T00:00:00+5", "2024-01-01T00:00:00+05:3", "2024-01-01T00:00:00+05:30x",
+    "2024-01-01T00:00:00Zx", "2024-01-01T00:00:00z", "2024-01-01T00:00", "",
+  };
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    t = 7;
+    CHECK(!parse(invalid[i], &t) && t == 7);
+  }
+}
+
+static void testLocalOffset(void) {
+  time_t t = 0;
+  // Values without suffix are in the local standard time, DST is ignored.
+  setenv("TZ", "AAA3", 1);
+  CHECK(parse("2024-01-01T00:00:00", &t) && t == NEW_YEAR + 3 * 3600);
+  setenv("TZ", "EST5EDT", 1);
+  CHECK(parse("2024-07-01T00:00:00", &t) && t == MID_YEAR + 5 * 3600);
+
+  // Offset is resolved once and then taken from the cache.
+  long tz = FLAGS_TZ_UNRESOLVED;
+  CHECK(parseTime("2024-01-01T00:00:00", &tz, &t) && tz == -5 * 3600);
+  tz = 3600;
+  CHECK(parseTime("2024-01-01T00:00:00", &tz, &t) && t == NEW_YEAR - 3600 && tz == 3600);
+  CHECK(parseTime("2024-01-01T00:00:00Z", &tz, &t) && t == NEW_YEAR);
+}
+
+static void testParses(void) {
+  time_t   start = 0, stop = 0;
+  FlagSet* fs    = flagSetNew();
+  flagSetTimeVar(fs, &start, "start", 0, 0, "start");
+  flagSetTimeVar(fs, &stop, "stop", 0, 0, "stop");
+  flagSetEnvPrefix(fs, "TIME_TEST");
+
+  // Arguments and environment of one parse share the offset.
+  setenv("TZ", "AAA3", 1);
+  setenv("TIME_TEST_STOP", "2024-01-01T00:00:00", 1);
+  char* argv[] = { "test", "--start", "2024-01-01T00:00:00" };
+  CHECK(flagSetParse(fs, 3, argv));
+  CHECK(start == NEW_YEAR + 3 * 3600 && stop == start);
+
+  // Every parse resolves the offset again.
+  setenv("TZ", "BBB-2", 1);
+  flagSetReset(fs);
+  CHECK(flagSetParse(fs, 3, argv));
+  CHECK(start == NEW_YEAR - 2 * 3600 && stop == start);
+
+  char* bad_argv[] = { "test", "--start", "2024-02-30T00:00:00Z" };
+  flagSetReset(fs);
+  CHECK(!flagSetParse(fs, 3, bad_argv));
+  CHECK(fs->ctx.error_code == FLAG_ERROR_CODE_INVALID_VALUE);
+
+  unsetenv("TIME_TEST_STOP");
+  flagSetFree(fs);
+}
+
+int main(void) {
+  testSuffixes();
+  testCalendar();
+  testLocalOffset();
+  testParses();
+  return 0;
+}
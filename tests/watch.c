@@ -0,0 +1,119 @@
+// Reloading of the configuration file by FlagWatch.
+
+#define FLAGS_IMPLEMENTATION
+#include "flag.h"
+#include "tests/test.h"
+
+#ifdef __linux__
+#include <pthread.h>
+
+static FlagWatch*   watch;
+static int          stop;
+
+// writeConfig replaces the file by renaming, as editors do.
+static void writeConfig(const char* path, int v) {
+  char tmp[64];
+  snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+  FILE* f = fopen(tmp, "w");
+  CHECK(f != NULL);
+  fprintf(f, "a = %d\nb = %d\nname = n%d\n", v, v, v);
+  fclose(f);
+  CHECK(rename(tmp, path) == 0);
+}
+
+// reader checks that every view holds values of a single reload.
+static void* reader(void* arg) {
+  (void)arg;
+  while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+    FlagView*          view = flagWatchAcquire(watch);
+    const FlagContext* ctx  = flagViewContext(view);
+    int                a    = flagContextInt(ctx, "a");
+    char               name[16];
+    snprintf(name, sizeof(name), "n%d", a);
+    CHECK(flagContextInt(ctx, "b") == a && strcmp(flagContextString(ctx, "name"), name) == 0);
+    flagViewRelease(view);
+  }
+  return NULL;
+}
+
+int main(void) {
+  FlagSet* fs = flagSetNew();
+  flagSetIntVar(fs, NULL, "a", 0, 1, "a");
+  flagSetIntVar(fs, NULL, "b", 0, 1, "b");
+  flagSetStringVar(fs, NULL, "name", 0, "n1", "name");
+
+  char dir[] = "/tmp/flag_watch_XXXXXX";
+  CHECK(mkdtemp(dir) != NULL);
+  char path[64];
+  snprintf(path, sizeof(path), "%s/app.ini", dir);
+
+  // Defaults are published if the file could not be loaded.
+  watch = flagWatchNew(fs, path);
+  CHECK(watch != NULL && flagWatchVersion(watch) == 0);
+  CHECK(flagWatchError(watch) == FLAG_ERROR_CODE_OPEN_CONFIG_FILE);
+  FlagView* view = flagWatchAcquire(watch);
+  CHECK(flagContextInt(flagViewContext(view), "a") == 1);
+  flagViewRelease(view);
+  flagWatchFree(watch);
+
+  writeConfig(path, 5);
+  watch = flagWatchNew(fs, path);
+  CHECK(watch != NULL && flagWatchVersion(watch) == 1);
+  CHECK(flagWatchError(watch) == FLAG_ERROR_CODE_NONE);
+
+  // Slow reader keeps its view valid across any number of reloads.
+  FlagView* held = flagWatchAcquire(watch);
+
+  pthread_t thread;
+  CHECK(pthread_create(&thread, NULL, reader, NULL) == 0);
+  for (int i = 6; i < 200; i++) {
+    writeConfig(path, i);
+    while (!flagWatchPoll(watch, 1000)) {
+    }
+  }
+
+  // Invalid file keeps the previous values published.
+  FILE* f = fopen(path, "w");
+  CHECK(f != NULL);
+  fprintf(f, "a = invalid\n");
+  fclose(f);
+  CHECK(!flagWatchPoll(watch, 1000));
+  CHECK(flagWatchError(watch) == FLAG_ERROR_CODE_INVALID_VALUE);
+  CHECK(strcmp(flagWatchErrorFlag(watch), "a") == 0);
+
+  __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+  pthread_join(thread, NULL);
+
+  CHECK(flagWatchVersion(watch) == 195);
+  view = flagWatchAcquire(watch);
+  CHECK(flagContextInt(flagViewContext(view), "a") == 199);
+  CHECK(strcmp(flagContextString(flagViewContext(view), "name"), "n199") == 0);
+  flagViewRelease(view);
+
+  CHECK(flagContextInt(flagViewContext(held), "a") == 5);
+  CHECK(strcmp(flagContextString(flagViewContext(held), "name"), "n5") == 0);
+
+  // Changes of other files in the directory do not reload.
+  char other[64];
+  snprintf(other, sizeof(other), "%s/other", dir);
+  f = fopen(other, "w");
+  CHECK(f != NULL);
+  fclose(f);
+  CHECK(!flagWatchPoll(watch, 100));
+
+  flagWatchFree(watch);
+  // Views outlive the watch.
+  CHECK(strcmp(flagContextString(flagViewContext(held), "name"), "n5") == 0);
+  flagViewRelease(held);
+
+  unlink(other);
+  unlink(path);
+  rmdir(dir);
+  flagSetFree(fs);
+  return 0;
+}
+#else
+int main(void) {
+  return 0;
+}
+#endif